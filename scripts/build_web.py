@@ -2,9 +2,18 @@ Import("env")
 import os
 import gzip
 import shutil
+import hashlib
 from pathlib import Path
 import re
 
+try:
+    import brotli  # pip install brotli : variantes .br en plus des .gz
+except ImportError:
+    brotli = None
+
+# Fichiers servis sous un nom stable (le service worker est enregistré par son nom)
+UNHASHED = {"sw.js"}
+
 def minify_html(content):
     """Minification HTML basique"""
     # Supprimer commentaires HTML
@@ -27,14 +36,26 @@ def minify_css(content):
 
 def minify_js(content):
     """Minification JS basique (pour minification avancée, utiliser terser)"""
-    # Supprimer commentaires //
-    content = re.sub(r'//.*?\n', '\n', content)
+    # Supprimer commentaires // (en début de ligne ou après un blanc : 'wss://' reste intact)
+    content = re.sub(r'(^|\s)//[^\n]*', r'\1', content, flags=re.MULTILINE)
     # Supprimer commentaires /* */
     content = re.sub(r'/\*.*?\*/', '', content, flags=re.DOTALL)
     # Supprimer espaces multiples
     content = re.sub(r'\s+', ' ', content)
     return content.strip()
 
+def hashed_name(name, content):
+    """styles.css -> styles.<8 hex>.css : le nom change quand le contenu change (cache immutable)"""
+    stem, ext = os.path.splitext(name)
+    digest = hashlib.sha256(content.encode('utf-8')).hexdigest()[:8]
+    return f"{stem}.{digest}{ext}"
+
+def rewrite_refs(html, renames):
+    """Remplace les références href/src vers les noms hashés ("/styles.css" ou "styles.css")"""
+    for old, new in renames.items():
+        html = re.sub(r'(?<=["\'/])' + re.escape(old) + r'(?=["\'?#)])', new, html)
+    return html
+
 def build_web_files(*args, **kwargs):
     print("\n" + "="*60)
     print("🔨 BUILD INTERFACE WEB - TigerTagScale")
@@ -66,11 +87,18 @@ def build_web_files(*args, **kwargs):
                 list(source_dir.glob("*.css")) + \
                 list(source_dir.glob("*.js"))
     
+    if brotli is None:
+        print("ℹ️  Module 'brotli' absent : variantes .gz uniquement (pip install brotli)\n")
+    
     if not web_files:
         print("⚠️  ATTENTION: Aucun fichier HTML/CSS/JS trouvé dans web-src/")
         print("   L'interface web ne sera pas disponible!\n")
         return
     
+    # CSS/JS d'abord : leurs noms hashés doivent être connus avant de réécrire le HTML
+    web_files.sort(key=lambda f: f.suffix == '.html')
+    renames = {}
+
     # Traiter chaque fichier
     for source_file in web_files:
         print(f"📄 {source_file.name}...")
@@ -83,6 +111,7 @@ def build_web_files(*args, **kwargs):
             # Minification selon type
             if source_file.suffix == '.html':
                 content = minify_html(content)
+                content = rewrite_refs(content, renames)
             elif source_file.suffix == '.css':
                 content = minify_css(content)
             elif source_file.suffix == '.js':
@@ -90,14 +119,26 @@ def build_web_files(*args, **kwargs):
             
             minified_size = len(content)
             
-            # Compression GZIP niveau 9 (maximum)
-            compressed = gzip.compress(content.encode('utf-8'), compresslevel=9)
+            out_name = source_file.name
+            if source_file.suffix in ('.css', '.js') and source_file.name not in UNHASHED:
+                out_name = hashed_name(source_file.name, content)
+                renames[source_file.name] = out_name
+                print(f"   🔖 {out_name}")
+            
+            # Compression GZIP niveau 9 (maximum), mtime=0 : même contenu -> mêmes octets (ETag stable)
+            compressed = gzip.compress(content.encode('utf-8'), compresslevel=9, mtime=0)
             compressed_size = len(compressed)
             
             # Sauvegarder avec extension .gz
-            output_file = data_dir / f"{source_file.name}.gz"
+            output_file = data_dir / f"{out_name}.gz"
             output_file.write_bytes(compressed)
             
+            # Variante brotli : le firmware sert la plus petite acceptée (Accept-Encoding)
+            if brotli is not None:
+                br = brotli.compress(content.encode('utf-8'), quality=11)
+                (data_dir / f"{out_name}.br").write_bytes(br)
+                print(f"   🟢 br {len(br):>6} B")
+            
             # Statistiques
             ratio = (1 - compressed_size / original_size) * 100 if original_size > 0 else 0
             print(f"   ✅ {original_size:>6} B → {minified_size:>6} B → {compressed_size:>6} B (-{ratio:.1f}%)")
@@ -139,4 +180,8 @@ env.AddPreAction("buildfs", build_web_files)
 # Hook PlatformIO: exécuter AVANT chaque compilation (pour être sûr)
 env.AddPreAction("$BUILD_DIR/${PROGNAME}.elf", build_web_files)
 
+# Hook PlatformIO: les cibles du web pack (scripts/build_webpack.py) lisent aussi data/www
+env.AddPreAction("webpack", build_web_files)
+env.AddPreAction("uploadwebpack", build_web_files)
+
 print("🔧 Script build_web.py chargé - compression automatique activée")
\ No newline at end of file
@@ -0,0 +1,183 @@
+# scripts/build_webpack.py
+# Empaquette data/www dans une image binaire pour la partition "webpack" (voir partitions.csv).
+# Le firmware la mappe en mémoire (esp_partition_mmap) et sert les fichiers directement depuis la flash,
+# sans LittleFS : index trié (recherche dichotomique), contenus texte pré-compressés (gzip, et brotli si le
+# module Python est installé). Le firmware choisit la plus petite variante acceptée par le client.
+#
+# Cibles PlatformIO :  pio run -t webpack        -> .pio/build/<env>/webpack.bin
+#                      pio run -t uploadwebpack  -> flash à l'offset de la partition
+# En ligne de commande : python scripts/build_webpack.py [data/www] [webpack.bin]
+#
+# Format (little-endian) :
+#   header  16 B : magic "TTWP", u16 version, u16 count, u32 totalLen, u32 crc32(octets 16..totalLen)
+#   index   24 B : u32 pathOff, u16 pathLen, u8 typeLen, u8 enc, u32 typeOff, u32 dataOff, u32 dataLen,
+#                  u32 etag (crc32 des données servies)
+#                  trié par (chemin, enc) ; enc 0 = identity, 1 = gzip, 2 = brotli
+#                  (plusieurs entrées par chemin : une par variante, adjacentes)
+#   chaînes      : chemins et Content-Type, terminés par NUL
+#   données      : alignées sur 4 octets
+
+import os
+import sys
+import gzip
+import struct
+import zlib
+
+try:
+    import brotli
+except ImportError:
+    brotli = None
+
+try:
+    Import("env")
+except NameError:
+    env = None
+
+MAGIC = b"TTWP"
+VERSION = 2
+HEADER = struct.Struct("<4sHHII")
+ENTRY = struct.Struct("<IHBBIIII")
+ENC_IDENTITY, ENC_GZIP, ENC_BROTLI = 0, 1, 2
+ENC_SUFFIX = {".gz": ENC_GZIP, ".br": ENC_BROTLI}
+
+PART_LABEL = "webpack"
+MAX_BINARY = 4096          # binaires plus gros (images, favicon.ico) : restent sur LittleFS
+
+MIME = {
+    ".html": "text/html; charset=utf-8",
+    ".css":  "text/css",
+    ".js":   "application/javascript",
+    ".json": "application/json",
+    ".svg":  "image/svg+xml",
+    ".txt":  "text/plain",
+    ".png":  "image/png",
+    ".ico":  "image/x-icon",
+}
+TEXT_EXTS = {".html", ".css", ".js", ".json", ".svg", ".txt"}
+
+
+def collect(www):
+    """Retourne {(chemin_url, enc): (content_type, données)} pour data/www."""
+    assets = {}
+    raw_text = {}
+    for root, _, files in os.walk(www):
+        for name in sorted(files):
+            full = os.path.join(root, name)
+            url = "/" + os.path.relpath(full, www).replace(os.sep, "/")
+            data = open(full, "rb").read()
+            suffix = os.path.splitext(name)[1].lower()
+            if suffix in ENC_SUFFIX:
+                # déjà compressé par build_web.py / gzip_www.py : prioritaire sur une compression locale
+                assets[(url[:-3], ENC_SUFFIX[suffix])] = data
+            elif suffix in TEXT_EXTS:
+                raw_text[url] = data
+            elif suffix in MIME and len(data) <= MAX_BINARY:
+                assets[(url, ENC_IDENTITY)] = data
+    for url, data in raw_text.items():
+        assets.setdefault((url, ENC_GZIP), gzip.compress(data, compresslevel=9, mtime=0))
+        if brotli is not None:
+            assets.setdefault((url, ENC_BROTLI), brotli.compress(data, quality=11))
+    out = {}
+    for (url, enc), data in assets.items():
+        ctype = MIME.get(os.path.splitext(url)[1].lower(), "application/octet-stream")
+        out[(url, enc)] = (ctype, data)
+    return out
+
+
+def build_pack(assets):
+    items = sorted(((url, enc, ctype, data) for (url, enc), (ctype, data) in assets.items()),
+                   key=lambda it: (it[0].encode("utf-8"), it[1]))
+    count = len(items)
+
+    # chaînes (Content-Type dédupliqués)
+    strings = bytearray()
+    str_base = HEADER.size + ENTRY.size * count
+    type_off = {}
+    path_off = []
+    for url, enc, ctype, _ in items:
+        path_off.append(str_base + len(strings))
+        strings += url.encode("utf-8") + b"\0"
+        if ctype not in type_off:
+            type_off[ctype] = str_base + len(strings)
+            strings += ctype.encode("ascii") + b"\0"
+
+    # données alignées sur 4
+    blob = bytearray()
+    data_base = str_base + len(strings)
+    data_base += (-data_base) % 4
+    data_off = []
+    for _, _, _, data in items:
+        data_off.append(data_base + len(blob))
+        blob += data
+        blob += b"\0" * ((-len(blob)) % 4)
+
+    index = bytearray()
+    for i, (url, enc, ctype, data) in enumerate(items):
+        index += ENTRY.pack(path_off[i], len(url.encode("utf-8")), len(ctype), enc,
+                            type_off[ctype], data_off[i], len(data), zlib.crc32(data) & 0xFFFFFFFF)
+
+    body = bytes(index) + bytes(strings)
+    body += b"\0" * (data_base - HEADER.size - len(body))
+    body += bytes(blob)
+    total = HEADER.size + len(body)
+    return HEADER.pack(MAGIC, VERSION, count, total, zlib.crc32(body) & 0xFFFFFFFF) + body
+
+
+def partition_info(csv_path, label=PART_LABEL):
+    """(offset, size) de la partition `label` dans partitions.csv."""
+    with open(csv_path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            cols = [c.strip() for c in line.split(",")]
+            if cols[0] == label:
+                return int(cols[3], 0), int(cols[4], 0)
+    raise RuntimeError(f"partition '{label}' absente de {csv_path}")
+
+
+def write_pack(www, out_path, max_size=None):
+    assets = collect(www)
+    pack = build_pack(assets)
+    if max_size is not None and len(pack) > max_size:
+        raise RuntimeError(f"webpack {len(pack)} B > partition {max_size} B")
+    os.makedirs(os.path.dirname(os.path.abspath(out_path)), exist_ok=True)
+    with open(out_path, "wb") as f:
+        f.write(pack)
+    names = {ENC_IDENTITY: "raw", ENC_GZIP: "gz ", ENC_BROTLI: "br "}
+    for (url, enc), (_, data) in sorted(assets.items()):
+        print(f"[webpack] {url:<28} {names[enc]} {len(data):>7} B")
+    print(f"[webpack] {len(assets)} asset(s), {len(pack)} B -> {out_path}")
+    return out_path
+
+
+if env is not None:
+    ROOT = env["PROJECT_DIR"]
+    WWW = os.path.join(ROOT, "data", "www")
+    PACK = os.path.join(env.subst("$BUILD_DIR"), "webpack.bin")
+    OFFSET, SIZE = partition_info(os.path.join(ROOT, "partitions.csv"))
+
+    def build_action(*args, **kwargs):
+        write_pack(WWW, PACK, SIZE)
+
+    def upload_action(*args, **kwargs):
+        write_pack(WWW, PACK, SIZE)
+        env.AutodetectUploadPort()
+        port = env.subst("$UPLOAD_PORT")
+        cmd = f'"$PYTHONEXE" "$UPLOADER" --chip esp32 {"--port " + port if port else ""} ' \
+              f'--baud $UPLOAD_SPEED write_flash {hex(OFFSET)} "{PACK}"'
+        return env.Execute(cmd)
+
+    env.AddCustomTarget("webpack", None, build_action, title="Build web pack",
+                        description="Pack data/www for the webpack partition")
+    env.AddCustomTarget("uploadwebpack", None, upload_action, title="Upload web pack",
+                        description="Flash the web pack at its partition offset")
+    print("🔧 Script build_webpack.py chargé - cibles 'webpack' / 'uploadwebpack'")
+
+elif __name__ == "__main__":
+    here = os.path.dirname(os.path.abspath(__file__))
+    root = os.path.dirname(here)
+    www = sys.argv[1] if len(sys.argv) > 1 else os.path.join(root, "data", "www")
+    out = sys.argv[2] if len(sys.argv) > 2 else os.path.join(root, ".pio", "build", "webpack.bin")
+    _, size = partition_info(os.path.join(root, "partitions.csv"))
+    write_pack(www, out, size)
@@ -9,6 +9,8 @@
 #include <AsyncTCP.h>
 #include <WiFiManager.h>
 #include <ESPAsyncWebServer.h>
+#include <WebResponseImpl.h>
+#include <type_traits>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include <ESPmDNS.h>
@@ -20,6 +22,8 @@
 #include <MFRC522.h>
 #include <SPI.h>
 #include <LittleFS.h>  // ← AJOUTÉ pour filesystem
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
 
 // ============================================================================
 // CONFIGURATION MATERIELLE
@@ -34,6 +38,11 @@
 // RFID RC522 (SPI)
 #define RC522_SS    5
 #define RC522_RST   27
+// SPI clock: MFRC522_SPICLOCK (build flag, RC522 accepts up to 10 MHz) is shared with the library.
+// RC522_FAST_TRANSPORT=0 falls back to the library's REQA/WUPA path (for before/after comparisons).
+#ifndef RC522_FAST_TRANSPORT
+#define RC522_FAST_TRANSPORT 1
+#endif
 
 // HX711 Balance
 #define HX711_DOUT  32
@@ -51,6 +60,7 @@
 // mDNS lifecycle helpers
 void startMDNS();
 void onWiFiEvent(WiFiEvent_t event);
+void statusTouch();
 
 // Unique Setup SSID + mDNS name derived from MAC
 String gSetupSsid;     // e.g. Setup-TigerScale-AB12
@@ -86,7 +96,6 @@ WiFiManager wm;
 String apiKey = "";
 String apiDisplayName = "";     // cached display name for validated API key
 bool apiValid = false;          // last known validation state
-uint32_t lastApiBroadcastMs = 0; // WS broadcast throttle for apiStatus
 float calibrationFactor = 406;
 float currentWeight = 0.0;
 // --- Hold mode variables ---
@@ -96,8 +105,138 @@ uint32_t holdStartMs = 0;
 const float HOLD_THRESHOLD_ENTER = 0.5f;
 const float HOLD_THRESHOLD_EXIT = 1.5f;
 const uint32_t HOLD_TIME_MS = 700;
-String lastUID = "";       // decimal UID for API/UI
-String lastUIDHex = "";    // hex UID for logs/debug
+
+// --- Tag UID value type: raw bytes + length, no heap. Formatted into caller buffers at the network edge ---
+const size_t UID_DEC_LEN = 21;   // uint64 decimal (20 digits) + NUL
+const size_t UID_HEX_LEN = 21;   // 10 bytes × 2 + NUL
+struct TagUid {
+    uint8_t len;                 // 0 = no tag, else 4, 7 or 10
+    uint8_t bytes[10];
+
+    bool empty() const { return len == 0; }
+    void clear() { len = 0; }
+    bool operator==(const TagUid& o) const { return len == o.len && memcmp(bytes, o.bytes, len) == 0; }
+    bool operator!=(const TagUid& o) const { return !(*this == o); }
+
+    // FNV-1a, cheap pre-check for cache/set lookups
+    uint32_t hash() const {
+        uint32_t h = 2166136261UL;
+        for (uint8_t i = 0; i < len; ++i) { h ^= bytes[i]; h *= 16777619UL; }
+        return h;
+    }
+
+    // Decimal of the big-endian UID value, the form the cloud API and the UI use ("" when empty)
+    char* toDec(char (&out)[UID_DEC_LEN]) const {
+        uint64_t v = 0ULL;
+        for (uint8_t i = 0; i < len; ++i) v = (v << 8) | bytes[i];
+        char tmp[UID_DEC_LEN];
+        int n = 0;
+        do { tmp[n++] = '0' + (char)(v % 10ULL); v /= 10ULL; } while (v && n < (int)UID_DEC_LEN - 1);
+        if (!len) n = 0;
+        for (int i = 0; i < n; ++i) out[i] = tmp[n - 1 - i];
+        out[n] = '\0';
+        return out;
+    }
+
+    char* toHex(char (&out)[UID_HEX_LEN]) const {
+        static const char digits[] = "0123456789ABCDEF";
+        for (uint8_t i = 0; i < len; ++i) {
+            out[2 * i]     = digits[bytes[i] >> 4];
+            out[2 * i + 1] = digits[bytes[i] & 0x0F];
+        }
+        out[2 * len] = '\0';
+        return out;
+    }
+
+    static TagUid from(const MFRC522::Uid& u) {
+        TagUid t;
+        t.len = u.size > sizeof(t.bytes) ? sizeof(t.bytes) : u.size;
+        memcpy(t.bytes, u.uidByte, t.len);
+        return t;
+    }
+
+    void toMfrc(MFRC522::Uid& u) const {
+        memset(&u, 0, sizeof(u));
+        u.size = len;
+        memcpy(u.uidByte, bytes, len);
+    }
+};
+
+TagUid lastUID = {};       // tag the next push goes to (cleared after a successful push)
+
+// --- Tag presence tracking ---
+const uint32_t TAG_PRESENCE_INTERVAL_MS = 250; // re-select period for the tag on the reader
+const uint8_t  TAG_REMOVE_MISSES = 3;          // consecutive missed re-selects before tagRemoved
+TagUid gTagUid = {};                           // tag currently in the field (kept after lastUID is cleared by a push)
+bool gTagPresent = false;
+uint8_t gTagMisses = 0;
+uint32_t gTagLastCheckMs = 0;
+
+// --- TigerTag payload (NTAG user memory) ---
+// Decoded fields of the TigerTag layout, pages 4..15 (big-endian).
+struct TigerTagData {
+    uint32_t tagId;        // p4   TigerTag format/version id
+    uint32_t productId;    // p5
+    uint16_t materialId;   // p6
+    uint8_t  aspect1;
+    uint8_t  aspect2;
+    uint8_t  typeId;       // p7
+    uint8_t  diameterId;
+    uint16_t brandId;
+    uint8_t  rgba[4];      // p8
+    uint32_t measure;      // p9   24-bit spool capacity
+    uint8_t  unitId;
+    uint16_t tempMin;      // p10
+    uint16_t tempMax;
+    uint8_t  dryTemp;      // p11
+    uint8_t  dryTime;
+    uint32_t timestamp;    // p13
+    uint32_t wbWeight;     // p14  scale write-back: 'W' marker + 24-bit grams
+    uint32_t wbTime;       // p15  epoch seconds of that weighing (0 = clock not synced)
+    bool     wbValid;
+};
+const uint8_t TIGERTAG_FIRST_PAGE = 4;
+const uint8_t TIGERTAG_LAST_PAGE  = 15;   // 12 pages = 48 bytes: one FAST_READ, or 3 x MIFARE_Read
+const int     TAG_CACHE_SIZE = 8;         // decoded records kept per session (LRU, keyed by UID)
+TigerTagData gTagData;                    // payload of the tag currently in the field
+bool gTagDataValid = false;
+
+// --- Weight write-back onto the tag (optional, persisted as "tagWb") ---
+const uint8_t TAG_WB_PAGE_WEIGHT = 14;    // reserved pages, inside the range read above
+const uint8_t TAG_WB_PAGE_TIME   = 15;
+const uint8_t TAG_WB_MARKER      = 'W';
+bool tagWriteBack = false;
+bool gWbDoneForHold = false;              // one write attempt per stable (hold) period
+
+// --- Batch inventory (every tag in the field, ISO14443A anticollision) ---
+const uint32_t INVENTORY_INTERVAL_MS = 1000;  // start of a new full scan cycle
+const uint32_t INVENTORY_BUDGET_MS   = 30;    // max RF time per loop() pass, a cycle resumes on the next pass
+const int      INVENTORY_MAX_TAGS    = 16;
+const uint8_t  INVENTORY_MAX_FAILS   = 3;     // consecutive failed selects before the cycle is closed
+const size_t   INVENTORY_FRAME_LEN   = 64 + 3 * INVENTORY_MAX_TAGS * (UID_DEC_LEN + 2);   // added/removed/tags
+TagUid gInvTags[INVENTORY_MAX_TAGS];          // last complete scan
+int gInvCount = 0;
+uint32_t gInvLastMs = 0;                      // completion time of the last scan
+
+// --- RC522 transport metrics (/api/rfid-stats) ---
+struct RfidStats {
+    uint32_t polls;         // REQA/WUPA issued
+    uint32_t spiBytes;      // bytes clocked by REQA/WUPA (library path: register cost + estimated polls)
+    uint32_t detects;       // successful request → UID reads
+    uint32_t lastDetectUs;
+    uint32_t maxDetectUs;
+    uint64_t sumDetectUs;
+};
+RfidStats gRfidStats = {0, 0, 0, 0, 0, 0};
+
+// --- RFID reader power policy: antenna off + soft power-down while the scale sits empty ---
+const float    RFID_SLEEP_ZERO_G   = 2.0f;    // |weight| below this counts as an empty scale
+const uint32_t RFID_SLEEP_AFTER_MS = 30000;   // empty this long (and no tag in the field) → reader sleeps
+const float    RFID_WAKE_DELTA_G   = 3.0f;    // raw change vs. the sleep baseline that wakes it up
+bool gRfidAsleep = false;
+uint32_t gRfidEmptySinceMs = 0;
+float gRfidSleepBaseline = 0.0f;
+uint32_t gRfidSleeps = 0;
 
 bool wifiConnected = false;
 bool cloudOK = false; // true if health endpoint returns {"ok":true}
@@ -122,6 +261,7 @@ uint32_t lastPushMs = 0;
 // --- Filters state (median + EMA) ---
 static float gEmaWeight = 0.0f;
 static bool  gEmaInit   = false;
+static float gRawWeight = 0.0f;   // last unfiltered sample, for instant load-change detection
 static float gMedianBuf[MEDIAN_WINDOW] = {0};
 static int   gMedianIdx = 0;
 static int   gMedianCount = 0; // <= MEDIAN_WINDOW
@@ -135,85 +275,496 @@ uint32_t sendPhaseLastChangeMs = 0;      // for expiring transient phases (succe
 // AFFICHAGE OLED
 // ============================================================================
 
-// 🔎 OLED Display: Utility to show multi-line status/info messages on the SSD1306 screen.
-//    Used for user feedback, errors, and setup states.
-void displayMessage(String line1, String line2 = "", String line3 = "", String line4 = "") {
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+// --- Display task: producers publish a UiState, a low-priority task renders and flushes ---
+#ifndef OLED_I2C_HZ
+#define OLED_I2C_HZ      400000UL            // 400 kHz (SSD1306 fast mode) .. 1 MHz (most modules cope)
+#endif
+#if OLED_I2C_HZ < 400000UL || OLED_I2C_HZ > 1000000UL
+#error "OLED_I2C_HZ must be between 400000 and 1000000"
+#endif
+#define OLED_PAGES       (OLED_HEIGHT / 8)
+#define OLED_I2C_BUF     (OLED_WIDTH + 1)    // Wire TX buffer: a whole page plus the 0x40 control byte
+#define DISPLAY_TASK_STACK 3072
+#define DISPLAY_TASK_PRIO  1                 // lowest user priority, below AsyncTCP and WiFi
+#define DISPLAY_TASK_CORE  0                 // off the loop() core: HX711/RFID never wait on I2C
+#define DISPLAY_IDLE_MS    1000              // wake-up without news, closes the bytes/s window
+
+// --- Trend sparkline: page 1 (y 8..15) of the weight screen, one column per sample ---
+#define SPARK_PAGE          1
+#define SPARK_STEP_MS       730              // one sample per step: a screen width is ~93 s of history
+#define SPARK_G_PER_PX      1.0f             // 8 px tall: about ±4 g around the reference
+#define SPARK_RECENTRE_STEPS OLED_WIDTH      // re-centre on the newest sample once per screen width
+
+enum UiScreen : uint8_t { UI_BOOT = 0, UI_WEIGHT, UI_MESSAGE };
+#define UI_LINE_LEN 32
+
+// Everything the renderer needs; producers never touch `display` themselves
+struct UiState {
+    UiScreen screen;
+    int      weightG;                        // already rounded
+    bool     hold;
+    bool     wifi;
+    uint32_t ip;
+    TagUid   uid;
+    char     lines[4][UI_LINE_LEN];          // UI_MESSAGE only
+};
+
+// --- Toasts: timed overlays composited over whatever screen is published ---
+enum ToastPrio : uint8_t { TOAST_INFO = 0, TOAST_OK, TOAST_ERROR };
+#define TOAST_QUEUE_LEN 4
+
+struct Toast {
+    char     lines[4][UI_LINE_LEN];
+    uint16_t durationMs;
+    uint8_t  prio;
+    uint32_t shownAtMs;                      // 0 = not on screen yet; the clock starts when it is
+};
+
+struct OledStats {
+    uint32_t framesSent;      // flushes that pushed at least one page
+    uint32_t framesSkipped;   // flushes with identical content: no I2C traffic
+    uint32_t pagesSent;
+    uint32_t i2cBytes;        // on the wire, address bytes included
+    uint32_t bytesPerSec;     // over the last closed 1 s window
+    uint32_t lastFrameUs;     // render + flush, display task time
+    uint32_t maxFrameUs;
+    uint32_t sparkSteps;      // sparkline samples (page 1 redrawn, sent through the page diff)
+    uint32_t sparkRecentres;  // reference moved to the newest sample
+};
+OledStats gOledStats = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static UiState gUi;                                   // latest published state, under gUiMux
+static uint32_t gUiSeq = 0;                           // bumped on every publish
+static portMUX_TYPE gUiMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t gDisplayTask = NULL;
+static Toast gToasts[TOAST_QUEUE_LEN];                // [0] is on screen; rest by prio desc, then FIFO
+static uint8_t gToastCount = 0;                       // under gUiMux, like gUi
+
+// Double buffer: display.getBuffer() is the back buffer GFX draws into,
+// gOledFront mirrors the panel RAM so a flush only sends what really differs.
+static uint8_t gOledFront[OLED_WIDTH * OLED_PAGES];
+static uint8_t gOledStale = 0xFF;            // pages whose panel RAM is unknown, sent in full (random at boot)
+static size_t gOledChunk = I2C_BUFFER_LENGTH;         // bytes per Wire transaction, control byte included
+static uint32_t gOledWindowStartMs = 0;
+static uint32_t gOledWindowBytes = 0;
+
+void oledRateUpdate(uint32_t now) {
+    const uint32_t elapsed = now - gOledWindowStartMs;
+    if (elapsed < 1000) return;
+    gOledStats.bytesPerSec = (uint32_t)((uint64_t)gOledWindowBytes * 1000 / elapsed);
+    gOledWindowBytes = 0;
+    gOledWindowStartMs = now;
+}
 
-    display.setCursor(0, 0);
-    display.println(line1);
+// Raw command stream; Adafruit's ssd1306_command() would drop the bus back to 100 kHz
+static void oledSendCommands(const uint8_t* cmd, uint8_t n) {
+    Wire.beginTransmission(OLED_ADDR);
+    Wire.write((uint8_t)0x00);                                  // control byte: command stream
+    Wire.write(cmd, n);
+    Wire.endTransmission();
+    gOledStats.i2cBytes += 2 + n;
+    gOledWindowBytes += 2 + n;
+}
 
-    if (line2.length() > 0) {
-        display.setCursor(0, 16);
-        display.println(line2);
+// PAGEADDR/COLUMNADDR window on columns [c0..c1] of one page, then the data in Wire-buffer-sized chunks
+static void oledSendSpan(uint8_t page, uint8_t c0, uint8_t c1, const uint8_t* data) {
+    const uint8_t win[] = { SSD1306_PAGEADDR, page, page, SSD1306_COLUMNADDR, c0, c1 };
+    oledSendCommands(win, sizeof(win));
+    uint32_t bytes = 0;
+
+    const uint16_t len = (uint16_t)(c1 - c0) + 1;
+    for (uint16_t off = 0; off < len; ) {
+        uint16_t n = min<uint16_t>(gOledChunk - 1, len - off);
+        Wire.beginTransmission(OLED_ADDR);
+        Wire.write((uint8_t)0x40);                              // control byte: data stream
+        Wire.write(data + off, n);
+        Wire.endTransmission();
+        bytes += 2 + n;
+        off += n;
     }
+    gOledStats.i2cBytes += bytes;
+    gOledWindowBytes += bytes;
+}
 
-    if (line3.length() > 0) {
-        display.setCursor(0, 32);
-        display.println(line3);
+// 🔎 OLED Flush: Replaces Adafruit_SSD1306::display(), which pushes all 1024 bytes every call.
+//    Back and front buffers are compared page by page; an identical frame costs no I2C at all,
+//    otherwise only the changed column span of each dirty page is sent. Display task only.
+void oledFlush() {
+    const uint8_t* back = display.getBuffer();
+    uint8_t sent = 0;
+    for (uint8_t p = 0; p < OLED_PAGES; ++p) {
+        const uint8_t bit = 1u << p;
+        const uint16_t base = (uint16_t)p * OLED_WIDTH;
+        uint8_t c0 = 0, c1 = OLED_WIDTH - 1;
+        if (!(gOledStale & bit)) {
+            if (memcmp(back + base, gOledFront + base, OLED_WIDTH) == 0) continue;
+            while (back[base + c0] == gOledFront[base + c0]) c0++;
+            while (back[base + c1] == gOledFront[base + c1]) c1--;
+        }
+        oledSendSpan(p, c0, c1, back + base + c0);
+        memcpy(gOledFront + base + c0, back + base + c0, (size_t)(c1 - c0) + 1);
+        gOledStale &= ~bit;
+        sent++;
     }
+    gOledStats.pagesSent += sent;
+    if (sent) gOledStats.framesSent++; else gOledStats.framesSkipped++;
+}
 
-    if (line4.length() > 0) {
-        display.setCursor(0, 48);
-        display.println(line4);
+// Sparkline state: the strip is redrawn in the back buffer at each step and goes out through
+// oledFlush()'s column diff, so a flat trend costs nothing and a moving one at most one page.
+// (The SSD1306 horizontal scroll would move it for free, but panel RAM must not be written while
+// it runs, and every other page changes far more often than once per step.)
+static volatile float gSparkWeight = NAN;   // latest live reading, fed by loop()
+static float gSparkHist[OLED_WIDTH];        // ring, gSparkHead = oldest
+static uint8_t gSparkHead = 0;
+static float gSparkRef = 0.0f;              // weight drawn on the middle row
+static uint32_t gSparkNextMs = 0;
+static uint16_t gSparkSinceCentre = 0;
+
+// Producer side: loop() hands over every filtered sample, not the held one
+inline void sparkFeed(float w) { gSparkWeight = w; }
+
+// One column: a single lit pixel, row 4 = reference, up = heavier. -1 when outside the strip.
+static int8_t sparkRow(float w) {
+    if (isnan(gSparkRef)) return -1;
+    const long d = lroundf((w - gSparkRef) / SPARK_G_PER_PX);
+    return (d < -3 || d > 4) ? -1 : (int8_t)(4 - d);
+}
+
+static uint8_t sparkColumn(float w) {
+    if (isnan(w)) return 0;
+    const int8_t row = sparkRow(w);
+    if (row >= 0) return (uint8_t)(1u << row);
+    return (w > gSparkRef) ? 0x01 : 0x80;       // pinned to the edge it left through
+}
+
+// Moves the reference (middle row) to the newest sample
+static void sparkRecentre() {
+    const float latest = gSparkHist[(gSparkHead + OLED_WIDTH - 1) % OLED_WIDTH];
+    gSparkRef = isnan(latest) ? (float)gSparkWeight : latest;
+    gSparkSinceCentre = 0;
+    gOledStats.sparkRecentres++;
+}
+
+// Draws the strip into the back buffer, oldest sample at x=0
+static void sparkDraw() {
+    uint8_t* row = display.getBuffer() + SPARK_PAGE * OLED_WIDTH;
+    for (uint8_t x = 0; x < OLED_WIDTH; ++x)
+        row[x] = sparkColumn(gSparkHist[(gSparkHead + x) % OLED_WIDTH]);
+}
+
+// Once per step: record the sample. Returns true when the strip has to be redrawn.
+static bool sparkStep(uint32_t now) {
+    if ((int32_t)(now - gSparkNextMs) < 0) return false;
+    gSparkNextMs += SPARK_STEP_MS;
+    if ((int32_t)(now - gSparkNextMs) >= 0) gSparkNextMs = now + SPARK_STEP_MS;   // fell behind: re-phase
+
+    const float w = gSparkWeight;
+    gSparkHist[gSparkHead] = w;
+    gSparkHead = (gSparkHead + 1) % OLED_WIDTH;
+    gOledStats.sparkSteps++;
+
+    if (++gSparkSinceCentre >= SPARK_RECENTRE_STEPS || (!isnan(w) && sparkRow(w) < 0)) sparkRecentre();
+    return true;
+}
+
+static void renderToast(const Toast& t) {
+    const bool inv = (t.prio == TOAST_ERROR);
+    const uint16_t bg = inv ? SSD1306_WHITE : SSD1306_BLACK;
+    const uint16_t fg = inv ? SSD1306_BLACK : SSD1306_WHITE;
+    // Box below the header and sparkline rows so both stay visible
+    display.fillRect(2, 16, OLED_WIDTH - 4, OLED_HEIGHT - 16, bg);
+    display.drawRect(2, 16, OLED_WIDTH - 4, OLED_HEIGHT - 16, SSD1306_WHITE);
+    display.setTextSize(1);
+    display.setTextColor(fg);
+    display.setTextWrap(false);
+    for (uint8_t i = 0; i < 4; ++i) {
+        if (!t.lines[i][0]) continue;
+        display.setCursor(6, 19 + i * 11);
+        display.print(t.lines[i]);
     }
+    display.setTextWrap(true);
+    display.setTextColor(SSD1306_WHITE);
+}
 
-    display.display();
+static void renderMessage(const UiState& s) {
+    display.clearDisplay();
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+    for (uint8_t i = 0; i < 4; ++i) {
+        if (i > 0 && !s.lines[i][0]) continue;
+        display.setCursor(0, i * 16);
+        display.println(s.lines[i]);
+    }
 }
 
-// 🔎 OLED Display: Shows the current weight and RFID UID, plus WiFi status, on the OLED.
-//    This function is called frequently to update the main UI shown to the user.
-void displayWeight(float weight, const String& uid = "");
+// --- Large-digit font: 7-segment glyphs rasterised at compile time into page-aligned columns ---
+#define BIG_W       16                       // glyph width (px)
+#define BIG_PAGES   4                        // glyph height: 4 pages = 32 px
+#define BIG_ADVANCE 18                       // glyph width + spacing
+#define BIG_GLYPHS  11                       // '0'..'9', '-'
 
-bool checkServerHealth();
-bool pushWeightToCloud(float w);
-void handleAutoPush(float w);
-bool validateApiKeyFirmware(const String& key, String& displayNameOut);
-bool deleteApiKey();
+// Segment masks, bit 0 = a (top) .. bit 6 = g (middle)
+constexpr uint8_t BIG_SEGS[BIG_GLYPHS] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, 0x40 };
 
-// 🔎 OLED Display: Main function for rendering weight and tag info on the OLED.
-//    Shows WiFi status, weight (large digits), UID, and device IP.
-void displayWeight(float weight, const String& uid) {
+constexpr bool bigIn(int x, int y, int x0, int x1, int y0, int y1) {
+    return x >= x0 && x <= x1 && y >= y0 && y <= y1;
+}
+constexpr bool bigPixel(unsigned g, int x, int y) {
+    return ((BIG_SEGS[g] & 0x01) && bigIn(x, y,  2, 13,  0,  2))    // a
+        || ((BIG_SEGS[g] & 0x02) && bigIn(x, y, 13, 15,  2, 15))    // b
+        || ((BIG_SEGS[g] & 0x04) && bigIn(x, y, 13, 15, 16, 29))    // c
+        || ((BIG_SEGS[g] & 0x08) && bigIn(x, y,  2, 13, 29, 31))    // d
+        || ((BIG_SEGS[g] & 0x10) && bigIn(x, y,  0,  2, 16, 29))    // e
+        || ((BIG_SEGS[g] & 0x20) && bigIn(x, y,  0,  2,  2, 15))    // f
+        || ((BIG_SEGS[g] & 0x40) && bigIn(x, y,  2, 13, 14, 16));   // g
+}
+// One SSD1306 column byte: 8 vertical pixels from y0 down, LSB on top
+constexpr uint8_t bigBits(unsigned g, int x, int y0, int k) {
+    return k == 8 ? 0 : (uint8_t)((bigPixel(g, x, y0 + k) ? (1u << k) : 0u) | bigBits(g, x, y0, k + 1));
+}
+constexpr uint8_t bigColumn(unsigned g, unsigned i) {   // i = page * BIG_W + x
+    return bigBits(g, (int)(i % BIG_W), (int)(i / BIG_W) * 8, 0);
+}
+
+template<unsigned... I> struct BigIdx {};
+template<unsigned N, unsigned... I> struct BigMakeIdx : BigMakeIdx<N - 1, N - 1, I...> {};
+template<unsigned... I> struct BigMakeIdx<0, I...> { typedef BigIdx<I...> type; };
+
+struct BigGlyph { uint8_t cols[BIG_PAGES * BIG_W]; };   // page-major: each page row is one memcpy
+template<unsigned... I> constexpr BigGlyph bigGlyph(unsigned g, BigIdx<I...>) {
+    return BigGlyph{{ bigColumn(g, I)... }};
+}
+#define BIG_GLYPH(g) bigGlyph(g, BigMakeIdx<BIG_PAGES * BIG_W>::type())
+
+constexpr BigGlyph BIG_FONT[BIG_GLYPHS] = {
+    BIG_GLYPH(0), BIG_GLYPH(1), BIG_GLYPH(2), BIG_GLYPH(3), BIG_GLYPH(4), BIG_GLYPH(5),
+    BIG_GLYPH(6), BIG_GLYPH(7), BIG_GLYPH(8), BIG_GLYPH(9), BIG_GLYPH(10)
+};
+static_assert(BIG_FONT[8].cols[0] == 0xFC, "big font: '8' left column, top page");
+
+// 🔎 Big digits: Blits a number straight into the framebuffer at page `page0`,
+//    one memcpy per glyph page instead of GFX's pixel-by-pixel scaled font. Returns the x after it.
+static int16_t blitBigNumber(int value, int16_t x, uint8_t page0) {
+    char txt[12];
+    snprintf(txt, sizeof(txt), "%d", value);
+    uint8_t* fb = display.getBuffer();
+    for (const char* c = txt; *c; ++c) {
+        if (x + BIG_W > OLED_WIDTH) break;
+        const BigGlyph& gl = BIG_FONT[*c == '-' ? 10 : *c - '0'];
+        for (uint8_t p = 0; p < BIG_PAGES; ++p)
+            memcpy(fb + (uint16_t)(page0 + p) * OLED_WIDTH + x, gl.cols + p * BIG_W, BIG_W);
+        x += BIG_ADVANCE;
+    }
+    return x;
+}
+
+static void renderWeight(const UiState& s) {
     display.clearDisplay();
-    
+    display.setTextColor(SSD1306_WHITE);
+
      // En-tête avec titre et statut WiFi
     display.setTextSize(1);
     display.setCursor(0, 0);
     display.println("Tiger-Scale");
-    
+
     display.setTextSize(1);
     display.setCursor(100, 0);
-    display.println(wifiConnected ? "WiFi" : "----");
+    display.println(s.wifi ? "WiFi" : "----");
 
     // Hold mode indicator (🅗 at x=112, y=0)
-    if (holdMode) { display.setCursor(112, 0); display.print("🅗"); }
-    
-    // Poids au centre (grande taille) — entier uniquement
-    int wInt = (int)(weight + (weight >= 0 ? 0.5f : -0.5f));
-    display.setTextSize(2);
-    display.setCursor(0, 20);
-    display.print(wInt);
-    display.println(" g");
-    
+    if (s.hold) { display.setCursor(112, 0); display.print("🅗"); }
+
+    // Poids au centre (grands chiffres pré-rendus, pages 2..5) — entier uniquement
+    const int16_t xUnit = blitBigNumber(s.weightG, 0, 2);
+    display.setTextSize(1);
+    display.setCursor(xUnit, 40);
+    display.print("g");
+
     // UID
-    if (uid.length() > 0) {
+    if (!s.uid.empty()) {
+        char uidDec[UID_DEC_LEN];
         display.setTextSize(1);
-        display.setCursor(0, 45);
+        display.setCursor(0, 48);
         display.print("UID:");
-        display.println(uid);
+        display.println(s.uid.toDec(uidDec));
     }
-    
+
     // IP en dessous de l'UID
     display.setTextSize(1);
     display.setCursor(0, 56);
-    if (wifiConnected) {
+    if (s.wifi) {
         display.print("IP: ");
-        display.println(WiFi.localIP().toString().c_str());
+        display.println(IPAddress(s.ip).toString().c_str());
     }
-    
-    display.display();
+}
+
+// Drops the on-screen toast once its time is up and starts the next one. Under gUiMux.
+// Returns true when what should be on screen changed.
+static bool toastAdvance(uint32_t now) {
+    bool changed = false;
+    if (gToastCount && gToasts[0].shownAtMs && now - gToasts[0].shownAtMs >= gToasts[0].durationMs) {
+        gToastCount--;
+        memmove(&gToasts[0], &gToasts[1], gToastCount * sizeof(Toast));
+        changed = true;
+    }
+    if (gToastCount && !gToasts[0].shownAtMs) {
+        gToasts[0].shownAtMs = now ? now : 1;
+        changed = true;
+    }
+    return changed;
+}
+
+// 🔎 Display Task: Sole owner of `display` and of the I2C bus after setup.
+//    Wakes on each publish, when the current toast expires, at each sparkline step, or every DISPLAY_IDLE_MS;
+//    renders the newest screen with the active toast on top, then flushes the diff.
+static void displayTask(void*) {
+    uint32_t seenSeq = 0;
+    uint32_t waitMs = DISPLAY_IDLE_MS;
+    UiState s;
+    Toast t;
+    bool hasToast = false;
+    bool spark = false;                     // weight screen on: the sparkline steps
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+        const uint32_t now = millis();
+        bool fresh = false;
+        portENTER_CRITICAL(&gUiMux);
+        if (toastAdvance(now) || gUiSeq != seenSeq) {
+            s = gUi;
+            seenSeq = gUiSeq;
+            hasToast = gToastCount > 0;
+            if (hasToast) t = gToasts[0];
+            fresh = true;
+        }
+        waitMs = DISPLAY_IDLE_MS;
+        if (gToastCount) {
+            const uint32_t left = gToasts[0].durationMs - (now - gToasts[0].shownAtMs);
+            if (left < waitMs) waitMs = left ? left : 1;
+        }
+        portEXIT_CRITICAL(&gUiMux);
+
+        if (fresh) {
+            const uint32_t t0 = micros();
+            if (s.screen == UI_MESSAGE) renderMessage(s); else renderWeight(s);
+            if (s.screen == UI_WEIGHT) {
+                if (!spark) { sparkRecentre(); gSparkNextMs = now + SPARK_STEP_MS; }
+                sparkDraw();
+            }
+            spark = s.screen == UI_WEIGHT;
+            if (hasToast) renderToast(t);
+            oledFlush();
+            const uint32_t dt = micros() - t0;
+            gOledStats.lastFrameUs = dt;
+            if (dt > gOledStats.maxFrameUs) gOledStats.maxFrameUs = dt;
+        }
+        if (spark) {
+            if (sparkStep(now)) {
+                sparkDraw();                // the rest of the back buffer still holds the last frame
+                oledFlush();
+            }
+            const uint32_t toStep = gSparkNextMs - now;
+            if (toStep < waitMs) waitMs = toStep ? toStep : 1;
+        }
+        oledRateUpdate(millis());
+    }
+}
+
+// Producers: copy the state in, poke the task, return. Safe from loop() and AsyncTCP handlers.
+static void uiPublish(const UiState& s) {
+    portENTER_CRITICAL(&gUiMux);
+    gUi = s;
+    gUiSeq++;
+    portEXIT_CRITICAL(&gUiMux);
+    if (gDisplayTask) xTaskNotifyGive(gDisplayTask);
+}
+
+// 🔎 OLED Setup: I2C bus, panel init, then hands the display over to its own task.
+//    The Wire buffer is grown before begin() so a whole page goes out in one transaction.
+void setupDisplay() {
+    if (Wire.setBufferSize(OLED_I2C_BUF) == OLED_I2C_BUF) gOledChunk = OLED_I2C_BUF;
+    for (uint8_t i = 0; i < OLED_WIDTH; ++i) gSparkHist[i] = NAN;
+    Wire.begin(21, 22);
+
+    if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDR)) {
+        Serial.println(F("Erreur OLED"));
+        while (1);
+    }
+    Wire.setClock(OLED_I2C_HZ); // begin() restores 100 kHz; oledFlush() talks to Wire directly
+
+    xTaskCreatePinnedToCore(displayTask, "display", DISPLAY_TASK_STACK, NULL,
+                            DISPLAY_TASK_PRIO, &gDisplayTask, DISPLAY_TASK_CORE);
+}
+
+static void copyLines(char (&dst)[4][UI_LINE_LEN], const String& l1, const String& l2, const String& l3, const String& l4) {
+    strlcpy(dst[0], l1.c_str(), UI_LINE_LEN);
+    strlcpy(dst[1], l2.c_str(), UI_LINE_LEN);
+    strlcpy(dst[2], l3.c_str(), UI_LINE_LEN);
+    strlcpy(dst[3], l4.c_str(), UI_LINE_LEN);
+}
+
+// 🔎 OLED Display: Utility to show multi-line status/info messages on the SSD1306 screen.
+//    Full-screen and persistent until the next publish: setup states (boot, WiFi portal).
+//    Transient feedback goes through showToast() instead.
+void displayMessage(String line1, String line2 = "", String line3 = "", String line4 = "") {
+    UiState s = UiState();
+    s.screen = UI_MESSAGE;
+    copyLines(s.lines, line1, line2, line3, line4);
+    uiPublish(s);
+}
+
+// 🔎 OLED Toast: Queues a timed overlay and returns at once; the display task shows it
+//    for `durationMs` over the live screen, then moves on to the next one.
+//    A higher priority replaces the toast on screen (progress gets superseded by its result),
+//    equal or lower ones wait their turn. When the queue is full the lowest-priority tail goes.
+void showToast(ToastPrio prio, uint16_t durationMs, const String& line1, const String& line2 = "",
+               const String& line3 = "", const String& line4 = "") {
+    Toast t;
+    copyLines(t.lines, line1, line2, line3, line4);
+    t.durationMs = durationMs;
+    t.prio = prio;
+    t.shownAtMs = 0;
+
+    portENTER_CRITICAL(&gUiMux);
+    if (gToastCount && prio > gToasts[0].prio) {
+        gToasts[0] = t;                                          // preempt
+    } else {
+        uint8_t pos = gToastCount;
+        while (pos > 1 && gToasts[pos - 1].prio < prio) pos--;  // keep [0] on screen
+        if (gToastCount == TOAST_QUEUE_LEN) {
+            if (pos == TOAST_QUEUE_LEN) { portEXIT_CRITICAL(&gUiMux); return; }
+            gToastCount--;
+        }
+        memmove(&gToasts[pos + 1], &gToasts[pos], (gToastCount - pos) * sizeof(Toast));
+        gToasts[pos] = t;
+        gToastCount++;
+    }
+    gUiSeq++;
+    portEXIT_CRITICAL(&gUiMux);
+    if (gDisplayTask) xTaskNotifyGive(gDisplayTask);
+}
+
+// 🔎 OLED Display: Shows the current weight and RFID UID, plus WiFi status, on the OLED.
+//    This function is called frequently to update the main UI shown to the user.
+void displayWeight(float weight, const TagUid& uid = TagUid());
+
+bool checkServerHealth();
+bool pushWeightToCloud(float w);
+void handleAutoPush(float w);
+bool validateApiKeyFirmware(const String& key, String& displayNameOut);
+bool deleteApiKey();
+
+// 🔎 OLED Display: Publishes the main weight screen (weight, UID, WiFi status, IP).
+//    Rendering happens in displayTask(); this only snapshots the values.
+void displayWeight(float weight, const TagUid& uid) {
+    UiState s = UiState();
+    s.screen = UI_WEIGHT;
+    s.weightG = (int)(weight + (weight >= 0 ? 0.5f : -0.5f));
+    s.hold = holdMode;
+    s.wifi = wifiConnected;
+    s.ip = wifiConnected ? (uint32_t)WiFi.localIP() : 0;
+    s.uid = uid;
+    uiPublish(s);
 }
 
 // ============================================================================
@@ -229,8 +780,7 @@ void configModeCallback(WiFiManager *myWiFiManager) {
 }
 
 void saveConfigCallback() {
-    displayMessage("Saving...", "Wi‑Fi config OK", "Reconnecting...");
-    delay(800);
+    showToast(TOAST_INFO, 800, "Saving...", "Wi‑Fi config OK", "Reconnecting...");
 }
 
 // 🔎 WiFiManager: Handles WiFi configuration and captive portal using WiFiManager.
@@ -251,7 +801,7 @@ void setupWiFi() {
     
     if (!wm.autoConnect(gSetupSsid.c_str())) {
         displayMessage("WiFi ERROR", "Restarting...");
-        delay(3000);
+        delay(3000); // restart back-off, not a display wait
         ESP.restart();
     }
     
@@ -266,16 +816,18 @@ void setupWiFi() {
     }
     wifiConnected = true;
 
+    // SNTP for tag write-back timestamps (keeps resyncing in the background)
+    configTime(0, 0, "pool.ntp.org", "time.google.com");
+
     // Check TigerTag cloud health (lightweight)
     cloudOK = checkServerHealth();
 
-    displayMessage(
+    showToast(cloudOK ? TOAST_INFO : TOAST_ERROR, 2000,
         "WiFi Connected!",
         WiFi.SSID(),
         WiFi.localIP().toString(),
         cloudOK ? "Cloud: OK" : "Cloud: FAIL"
     );
-    delay(2000);
 }
 
 // ============================================================================
@@ -320,8 +872,7 @@ void setupFileSystem() {
     
     if (!LittleFS.begin(true)) {  // true = format si échec
         Serial.println("❌ [LITTLEFS] Échec montage!");
-        displayMessage("ERROR", "Filesystem FAIL", "Check data/");
-        delay(3000);
+        showToast(TOAST_ERROR, 3000, "ERROR", "Filesystem FAIL", "Check data/");
         return;
     }
     
@@ -338,6 +889,253 @@ void setupFileSystem() {
     listDir(LittleFS, "/www", 3);
 }
 
+// ============================================
+// PACK WEB EN FLASH (partition "webpack", mappée en mémoire)
+// ============================================
+// Built by scripts/build_webpack.py from data/www: header, index sorted by path, strings, data.
+// Served straight from the mapped flash: no FS metadata walk, no intermediate RAM buffer.
+#define WEBPACK_PART_SUBTYPE 0x40
+#define WEBPACK_PART_LABEL   "webpack"
+#define WEBPACK_VERSION      2
+#define CACHE_IMMUTABLE      "public, max-age=31536000, immutable"   // content-hashed names only
+#define CACHE_REVALIDATE     "no-cache"                              // may be stored, ETag checked each use
+
+enum WebPackEnc : uint8_t { WP_IDENTITY = 0, WP_GZIP = 1, WP_BROTLI = 2 };
+
+struct WebPackHeader {
+    char     magic[4];                  // "TTWP"
+    uint16_t version;
+    uint16_t count;
+    uint32_t totalLen;
+    uint32_t crc32;                     // over bytes [sizeof(header) .. totalLen)
+};
+struct WebPackEntry {
+    uint32_t pathOff;
+    uint16_t pathLen;
+    uint8_t  typeLen;
+    uint8_t  enc;                       // WebPackEnc
+    uint32_t typeOff;                   // NUL-terminated Content-Type
+    uint32_t dataOff;
+    uint32_t dataLen;
+    uint32_t etag;                      // crc32 of the served bytes
+};
+static_assert(sizeof(WebPackHeader) == 16 && sizeof(WebPackEntry) == 24, "webpack layout (see build_webpack.py)");
+
+static const uint8_t* gWebPack = NULL;           // NULL = no valid pack, LittleFS answers alone
+static const WebPackEntry* gWebPackIndex = NULL;
+static uint16_t gWebPackCount = 0;
+
+// 🔎 Web Pack: Maps the "webpack" partition and validates it (magic, version, bounds, CRC).
+//    Mapped once for the lifetime of the firmware; a blank or stale partition just disables it.
+void setupWebPack() {
+    const esp_partition_t* part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)WEBPACK_PART_SUBTYPE, WEBPACK_PART_LABEL);
+    if (!part) { Serial.println("[WEBPACK] no partition, LittleFS only"); return; }
+
+    const void* map = NULL;
+    spi_flash_mmap_handle_t handle;
+    if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &map, &handle) != ESP_OK) {
+        Serial.println("[WEBPACK] mmap failed");
+        return;
+    }
+    const uint8_t* base = (const uint8_t*)map;
+    const WebPackHeader* h = (const WebPackHeader*)base;
+    const bool ok = memcmp(h->magic, "TTWP", 4) == 0 && h->version == WEBPACK_VERSION
+        && h->totalLen <= part->size
+        && sizeof(WebPackHeader) + (uint32_t)h->count * sizeof(WebPackEntry) <= h->totalLen
+        && esp_rom_crc32_le(0, base + sizeof(WebPackHeader), h->totalLen - sizeof(WebPackHeader)) == h->crc32;
+    if (!ok) {
+        Serial.println("[WEBPACK] empty or invalid image → pio run -t uploadwebpack");
+        spi_flash_munmap(handle);
+        return;
+    }
+    gWebPack = base;
+    gWebPackIndex = (const WebPackEntry*)(base + sizeof(WebPackHeader));
+    gWebPackCount = h->count;
+    Serial.printf("✅ [WEBPACK] %u assets, %lu bytes mapped\n", gWebPackCount, (unsigned long)h->totalLen);
+}
+
+static int webPackCompare(const WebPackEntry& e, const char* path, size_t len) {
+    const size_t n = e.pathLen < len ? e.pathLen : len;
+    const int c = memcmp(gWebPack + e.pathOff, path, n);
+    if (c) return c;
+    return (e.pathLen < len) ? -1 : (e.pathLen > len ? 1 : 0);
+}
+
+// URL → pack/FS path: "/" is the page itself
+static const char* webPackPath(const String& url, size_t& len) {
+    if (url.length() == 1 && url[0] == '/') { len = 11; return "/index.html"; }
+    len = url.length();
+    return url.c_str();
+}
+
+// Binary search on the sorted index; returns the first entry (variant) for `path`
+const WebPackEntry* webPackFind(const char* path, size_t len) {
+    if (!gWebPack) return NULL;
+    uint16_t lo = 0, hi = gWebPackCount;
+    while (lo < hi) {
+        const uint16_t mid = (lo + hi) / 2;
+        if (webPackCompare(gWebPackIndex[mid], path, len) < 0) lo = mid + 1; else hi = mid;
+    }
+    return (lo < gWebPackCount && webPackCompare(gWebPackIndex[lo], path, len) == 0) ? &gWebPackIndex[lo] : NULL;
+}
+
+// build_web.py names CSS/JS "<stem>.<8 hex>.<ext>": such a URL never changes content
+bool isHashedAsset(const String& url) {
+    const int ext = url.lastIndexOf('.');
+    if (ext < 9 || url[ext - 9] != '.') return false;
+    for (int i = ext - 8; i < ext; ++i) {
+        const char c = url[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+// If-None-Match may carry a list and/or W/ prefixes; a substring match on the quoted tag is enough
+static bool etagMatches(AsyncWebServerRequest *request, const char* etag) {
+    return request->hasHeader("If-None-Match") && request->header("If-None-Match").indexOf(etag) >= 0;
+}
+
+// --- Single static handler: web pack first, LittleFS second, encoding negotiated per request ---
+static const char* const kEncodingName[] = { NULL, "gzip", "br" };   // by WebPackEnc
+static const char* const kEncodingExt[]  = { "", ".gz", ".br" };
+
+// Accept-Encoding → bitmask of WebPackEnc; honours q=0. Identity stays acceptable unless refused
+// (text assets have no identity variant: resolveAsset() falls back to gzip).
+static uint8_t acceptedEncodings(AsyncWebServerRequest *request) {
+    uint8_t mask = 1u << WP_IDENTITY;
+    if (!request->hasHeader("Accept-Encoding")) return mask;
+    const String& ae = request->header("Accept-Encoding");
+    int start = 0;
+    while (start < (int)ae.length()) {
+        int end = ae.indexOf(',', start);
+        if (end < 0) end = ae.length();
+        String tok = ae.substring(start, end);
+        start = end + 1;
+        tok.trim();
+        const int semi = tok.indexOf(';');
+        String name = semi < 0 ? tok : tok.substring(0, semi);
+        name.trim();
+        const int q = semi < 0 ? -1 : tok.indexOf("q=", semi);
+        const bool refused = q >= 0 && tok.substring(q + 2).toFloat() <= 0.0f;
+
+        uint8_t bits = 0;
+        if (name.equalsIgnoreCase("gzip"))          bits = 1u << WP_GZIP;
+        else if (name.equalsIgnoreCase("br"))       bits = 1u << WP_BROTLI;
+        else if (name.equalsIgnoreCase("identity")) bits = 1u << WP_IDENTITY;
+        else if (name == "*")                       bits = (1u << WP_GZIP) | (1u << WP_BROTLI) | (1u << WP_IDENTITY);
+        if (refused) mask &= ~bits; else mask |= bits;
+    }
+    return mask;
+}
+
+static const char* contentTypeFor(const char* path, size_t len) {
+    const char* dot = NULL;
+    for (const char* p = path + len; p > path; --p) if (p[-1] == '.') { dot = p - 1; break; }
+    if (!dot) return "application/octet-stream";
+    if (!strncmp(dot, ".html", 5)) return "text/html; charset=utf-8";
+    if (!strncmp(dot, ".css", 4))  return "text/css";
+    if (!strncmp(dot, ".js", 3))   return "application/javascript";
+    if (!strncmp(dot, ".json", 5)) return "application/json";
+    if (!strncmp(dot, ".svg", 4))  return "image/svg+xml";
+    if (!strncmp(dot, ".png", 4))  return "image/png";
+    if (!strncmp(dot, ".ico", 4))  return "image/x-icon";
+    return "application/octet-stream";
+}
+
+// What canHandle() resolved; handed to handleRequest() through request->_tempObject (freed by the request)
+struct AssetChoice {
+    const WebPackEntry* entry;          // pack variant, or NULL when served from LittleFS
+    uint32_t size;
+    uint8_t  enc;                       // WebPackEnc
+    char     fsPath[64];
+    char     etag[24];
+};
+
+// 🔎 Asset Resolution: Among the variants the client accepts, pick the smallest.
+//    Pack variants of one path sit next to each other in the sorted index; LittleFS is only
+//    walked when the pack has no acceptable variant (or no pack at all).
+static bool resolveAssetAs(AsyncWebServerRequest *request, uint8_t accepted, AssetChoice& c) {
+    size_t len;
+    const char* path = webPackPath(request->url(), len);
+    c.entry = NULL;
+    c.size = UINT32_MAX;
+
+    const WebPackEntry* end = gWebPackIndex + gWebPackCount;
+    for (const WebPackEntry* e = webPackFind(path, len); e && e < end && webPackCompare(*e, path, len) == 0; ++e) {
+        if (!(accepted & (1u << e->enc)) || e->dataLen >= c.size) continue;
+        c.entry = e;
+        c.size = e->dataLen;
+        c.enc = e->enc;
+    }
+    if (c.entry) {
+        snprintf(c.etag, sizeof(c.etag), "\"%08lx\"", (unsigned long)c.entry->etag);
+        return true;
+    }
+
+    for (uint8_t enc = WP_IDENTITY; enc <= WP_BROTLI; ++enc) {
+        if (!(accepted & (1u << enc))) continue;
+        char p[sizeof(c.fsPath)];
+        const int n = snprintf(p, sizeof(p), "/www%.*s%s", (int)len, path, kEncodingExt[enc]);
+        if (n <= 0 || n >= (int)sizeof(p) || !LittleFS.exists(p)) continue;
+        File f = LittleFS.open(p, "r");
+        if (!f || f.isDirectory() || f.size() >= c.size) continue;
+        c.size = f.size();
+        c.enc = enc;
+        strlcpy(c.fsPath, p, sizeof(c.fsPath));
+        snprintf(c.etag, sizeof(c.etag), "\"%lx-%lx\"", (unsigned long)c.size, (unsigned long)f.getLastWrite());
+    }
+    return c.size != UINT32_MAX;
+}
+
+// Text assets only exist compressed: a client that accepts none of the variants (no Accept-Encoding,
+// "identity") still gets the gzip one, labelled as such, rather than a 404.
+static bool resolveAsset(AsyncWebServerRequest *request, AssetChoice& c) {
+    const uint8_t accepted = acceptedEncodings(request);
+    if (resolveAssetAs(request, accepted, c)) return true;
+    return !(accepted & (1u << WP_GZIP)) && resolveAssetAs(request, accepted | (1u << WP_GZIP), c);
+}
+
+class WebAssetHandler : public AsyncWebHandler {
+public:
+    bool canHandle(AsyncWebServerRequest *request) override {
+        if (request->method() != HTTP_GET) return false;
+        AssetChoice c;
+        if (!resolveAsset(request, c)) return false;
+        void* slot = malloc(sizeof(AssetChoice));
+        if (!slot) return false;
+        memcpy(slot, &c, sizeof(c));
+        request->_tempObject = slot;
+        request->addInterestingHeader("If-None-Match");
+        return true;
+    }
+    void handleRequest(AsyncWebServerRequest *request) override {
+        const AssetChoice* c = (const AssetChoice*)request->_tempObject;
+        if (!c) { request->send(404, "text/plain", "404 Not Found"); return; }
+        size_t len;
+        const char* path = webPackPath(request->url(), len);
+
+        AsyncWebServerResponse *response;
+        if (etagMatches(request, c->etag)) {
+            response = request->beginResponse(304);
+        } else {
+            if (c->entry) {
+                // Progmem response: chunks are copied from mapped flash straight into the TCP buffer
+                response = request->beginResponse_P(
+                    200, (const char*)(gWebPack + c->entry->typeOff), gWebPack + c->entry->dataOff, c->entry->dataLen);
+            } else {
+                response = request->beginResponse(LittleFS, c->fsPath, contentTypeFor(path, len));
+            }
+            if (c->enc != WP_IDENTITY) response->addHeader("Content-Encoding", kEncodingName[c->enc]);
+        }
+        response->addHeader("Vary", "Accept-Encoding");
+        response->addHeader("ETag", c->etag);
+        response->addHeader("Cache-Control", isHashedAsset(request->url()) ? CACHE_IMMUTABLE : CACHE_REVALIDATE);
+        request->send(response);
+    }
+};
+WebAssetHandler gWebAssetHandler;
+
 // Validate API key against TigerTag CDN (firmware-side)
 bool validateApiKeyFirmware(const String& key, String& displayNameOut) {
     displayNameOut = "";
@@ -387,6 +1185,7 @@ bool deleteApiKey() {
     apiKey = "";
     apiDisplayName = "";
     apiValid = false;
+    statusTouch();
     Serial.println("[APIKEY] deleteApiKey(): end");
     return removed;
 }
@@ -398,195 +1197,1439 @@ bool deleteApiKey() {
 // ⚠️ SUPPRIMÉ : const char index_html[] PROGMEM = R"rawliteral(...
 // Les fichiers HTML sont maintenant servis depuis LittleFS
 
-AsyncWebSocket ws("/ws");
+// --- State schema: field lists declared once, JSON/MessagePack writers and size bounds derived at compile time ---
+// A message is a Schema<Field...> over a plain struct. Each Field names a member, its key and its
+// Kind; the Kind knows how to write the value in both encodings and the most bytes that can take
+// (strings: every byte escaped as \u00XX). Schema::toJson()/toMsgPack() only accept a buffer of at
+// least jsonMax/mpMax bytes (static_assert), so they write without bounds checks or reallocation.
+
+constexpr size_t cmax(size_t a, size_t b) { return a > b ? a : b; }
+constexpr size_t mpStrHdr(size_t n) { return n < 32 ? 1 : n < 256 ? 2 : 3; }
+constexpr size_t mpMapHdr(size_t n) { return n < 16 ? 1 : 3; }
+constexpr uint32_t pow10u(unsigned d) { return d == 0 ? 1 : 10 * pow10u(d - 1); }
+
+static char* jsonU32(char* p, uint32_t v) {
+    char t[10];
+    int n = 0;
+    do { t[n++] = '0' + (char)(v % 10); v /= 10; } while (v);
+    while (n) *p++ = t[--n];
+    return p;
+}
+
+static char* jsonI32(char* p, int32_t v) {
+    if (v < 0) { *p++ = '-'; return jsonU32(p, 0u - (uint32_t)v); }
+    return jsonU32(p, (uint32_t)v);
+}
+
+static char* jsonStr(char* p, const char* s, size_t max) {
+    static const char hex[] = "0123456789abcdef";
+    *p++ = '"';
+    for (size_t i = 0; i < max && s[i]; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\') { *p++ = '\\'; *p++ = (char)c; }
+        else if (c < 0x20) { memcpy(p, "\\u00", 4); p[4] = hex[c >> 4]; p[5] = hex[c & 0x0F]; p += 6; }
+        else *p++ = (char)c;
+    }
+    *p++ = '"';
+    return p;
+}
+
+static uint8_t* mpBe(uint8_t* p, uint32_t v, int bytes) {
+    while (bytes--) *p++ = (uint8_t)(v >> (8 * bytes));
+    return p;
+}
+
+static uint8_t* mpU32(uint8_t* p, uint32_t v) {
+    if (v < 0x80)    { *p++ = (uint8_t)v; return p; }
+    if (v < 0x100)   { *p++ = 0xCC; return mpBe(p, v, 1); }
+    if (v < 0x10000) { *p++ = 0xCD; return mpBe(p, v, 2); }
+    *p++ = 0xCE;
+    return mpBe(p, v, 4);
+}
+
+static uint8_t* mpI32(uint8_t* p, int32_t v) {
+    if (v >= 0)      return mpU32(p, (uint32_t)v);
+    if (v >= -32)    { *p++ = (uint8_t)v; return p; }
+    if (v >= -128)   { *p++ = 0xD0; return mpBe(p, (uint32_t)v, 1); }
+    if (v >= -32768) { *p++ = 0xD1; return mpBe(p, (uint32_t)v, 2); }
+    *p++ = 0xD2;
+    return mpBe(p, (uint32_t)v, 4);
+}
+
+static uint8_t* mpStr(uint8_t* p, const char* s, size_t n) {
+    if (n < 32)       *p++ = (uint8_t)(0xA0 | n);
+    else if (n < 256) { *p++ = 0xD9; *p++ = (uint8_t)n; }
+    else              { *p++ = 0xDA; p = mpBe(p, n, 2); }
+    memcpy(p, s, n);
+    return p + n;
+}
+
+static uint8_t* mpMap(uint8_t* p, size_t n) {
+    if (n < 16) { *p++ = (uint8_t)(0x80 | n); return p; }
+    *p++ = 0xDE;
+    return mpBe(p, n, 2);
+}
+
+static uint8_t* mpF32(uint8_t* p, float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    *p++ = 0xCA;
+    return mpBe(p, bits, 4);
+}
+
+// Integers up to 32 bits
+template<typename T> struct KNum {
+    typedef T Type;
+    static constexpr size_t jsonMax = std::is_signed<T>::value ? 11 : 10;
+    static constexpr size_t mpMax = 5;
+    static void json(char*& p, const T& v) { p = std::is_signed<T>::value ? jsonI32(p, (int32_t)v) : jsonU32(p, (uint32_t)v); }
+    static void msgpack(uint8_t*& p, const T& v) { p = std::is_signed<T>::value ? mpI32(p, (int32_t)v) : mpU32(p, (uint32_t)v); }
+    static_assert(sizeof(T) <= 4, "KNum is 32-bit");
+};
+
+struct KBool {
+    typedef bool Type;
+    static constexpr size_t jsonMax = 5;
+    static constexpr size_t mpMax = 1;
+    static void json(char*& p, const bool& v) { memcpy(p, v ? "true" : "false", v ? 4 : 5); p += v ? 4 : 5; }
+    static void msgpack(uint8_t*& p, const bool& v) { *p++ = v ? 0xC3 : 0xC2; }
+};
+
+// Fixed point: the member holds value × 10^D, printed with exactly D decimals (MessagePack: float32)
+template<unsigned D> struct KFixed {
+    typedef int32_t Type;
+    static constexpr size_t jsonMax = 1 + 10 + 1 + D;
+    static constexpr size_t mpMax = 5;
+    static void json(char*& p, const int32_t& v) {
+        uint32_t a = v < 0 ? 0u - (uint32_t)v : (uint32_t)v;
+        if (v < 0) *p++ = '-';
+        p = jsonU32(p, a / pow10u(D));
+        *p++ = '.';
+        uint32_t frac = a % pow10u(D);
+        for (unsigned i = D; i-- > 0;) { p[i] = '0' + (char)(frac % 10); frac /= 10; }
+        p += D;
+    }
+    static void msgpack(uint8_t*& p, const int32_t& v) { p = mpF32(p, (float)v / (float)pow10u(D)); }
+};
+
+// NUL-terminated char[N]
+template<size_t N> struct KStr {
+    typedef char Type[N];
+    static constexpr size_t jsonMax = 2 + 6 * (N - 1);
+    static constexpr size_t mpMax = mpStrHdr(N - 1) + N - 1;
+    static void json(char*& p, const Type& v) { p = jsonStr(p, v, N - 1); }
+    static void msgpack(uint8_t*& p, const Type& v) { p = mpStr(p, v, strnlen(v, N - 1)); }
+};
+
+// float with D decimals; null when not finite (MessagePack: float32)
+template<unsigned D> struct KFloat {
+    typedef float Type;
+    static constexpr size_t jsonMax = 1 + 39 + 1 + D;        // ±FLT_MAX printed in full
+    static constexpr size_t mpMax = 5;
+    static void json(char*& p, const float& v) {
+        if (!std::isfinite(v)) { memcpy(p, "null", 4); p += 4; return; }
+        p += snprintf(p, jsonMax + 1, "%.*f", (int)D, (double)v);
+    }
+    static void msgpack(uint8_t*& p, const float& v) { p = mpF32(p, v); }
+};
+
+// Pointer to a string literal of at most N - 1 characters
+template<size_t N> struct KLabel {
+    typedef const char* Type;
+    static constexpr size_t jsonMax = KStr<N>::jsonMax;
+    static constexpr size_t mpMax = KStr<N>::mpMax;
+    static void json(char*& p, const Type& v) { p = jsonStr(p, v, N - 1); }
+    static void msgpack(uint8_t*& p, const Type& v) { p = mpStr(p, v, strnlen(v, N - 1)); }
+};
+
+// Byte array as an uppercase hex string
+template<size_t N> struct KHex {
+    typedef uint8_t Type[N];
+    static constexpr size_t jsonMax = 2 + 2 * N;
+    static constexpr size_t mpMax = mpStrHdr(2 * N) + 2 * N;
+    static void hex(char* out, const Type& v) {
+        static const char digits[] = "0123456789ABCDEF";
+        for (size_t i = 0; i < N; i++) { out[2 * i] = digits[v[i] >> 4]; out[2 * i + 1] = digits[v[i] & 0x0F]; }
+    }
+    static void json(char*& p, const Type& v) { *p++ = '"'; hex(p, v); p += 2 * N; *p++ = '"'; }
+    static void msgpack(uint8_t*& p, const Type& v) { char h[2 * N]; hex(h, v); p = mpStr(p, h, 2 * N); }
+};
+
+// Two integers as [a,b]
+template<typename T> struct KPair {
+    typedef T Type[2];
+    static constexpr size_t jsonMax = 3 + 2 * KNum<T>::jsonMax;
+    static constexpr size_t mpMax = 1 + 2 * KNum<T>::mpMax;
+    static void json(char*& p, const Type& v) { *p++ = '['; KNum<T>::json(p, v[0]); *p++ = ','; KNum<T>::json(p, v[1]); *p++ = ']'; }
+    static void msgpack(uint8_t*& p, const Type& v) { *p++ = 0x92; KNum<T>::msgpack(p, v[0]); KNum<T>::msgpack(p, v[1]); }
+};
+
+// IPv4 in network order (as IPAddress casts it) as "a.b.c.d"
+struct KIp4 {
+    typedef uint32_t Type;
+    static constexpr size_t jsonMax = 2 + 15;
+    static constexpr size_t mpMax = 1 + 15;
+    static size_t dotted(char* out, uint32_t ip) {
+        char* p = out;
+        for (int i = 0; i < 4; i++) { if (i) *p++ = '.'; p = jsonU32(p, (ip >> (8 * i)) & 0xFF); }
+        return p - out;
+    }
+    static void json(char*& p, const uint32_t& v) { *p++ = '"'; p += dotted(p, v); *p++ = '"'; }
+    static void msgpack(uint8_t*& p, const uint32_t& v) { char s[15]; p = mpStr(p, s, dotted(s, v)); }
+};
+
+// Tag UID in the decimal form the cloud and the UI use, or hex
+struct KUidDec {
+    typedef TagUid Type;
+    static constexpr size_t jsonMax = 2 + UID_DEC_LEN - 1;
+    static constexpr size_t mpMax = 1 + UID_DEC_LEN - 1;
+    static void json(char*& p, const TagUid& v) { char s[UID_DEC_LEN]; p = jsonStr(p, v.toDec(s), UID_DEC_LEN - 1); }
+    static void msgpack(uint8_t*& p, const TagUid& v) { char s[UID_DEC_LEN]; v.toDec(s); p = mpStr(p, s, strlen(s)); }
+};
+
+struct KUidHex {
+    typedef TagUid Type;
+    static constexpr size_t jsonMax = 2 + UID_HEX_LEN - 1;
+    static constexpr size_t mpMax = 1 + UID_HEX_LEN - 1;
+    static void json(char*& p, const TagUid& v) { char s[UID_HEX_LEN]; p = jsonStr(p, v.toHex(s), UID_HEX_LEN - 1); }
+    static void msgpack(uint8_t*& p, const TagUid& v) { char s[UID_HEX_LEN]; v.toHex(s); p = mpStr(p, s, strlen(s)); }
+};
+
+// Field descriptor: Owner::member written under "key" with Kind
+#define SCHEMA_FIELD(Owner, member, Kind, key)                                              \
+    struct Owner##_##member {                                                               \
+        typedef Owner Own;                                                                  \
+        typedef Kind K;                                                                     \
+        static const char* name() { return key; }                                           \
+        static constexpr size_t nameLen = sizeof(key) - 1;                                  \
+        static const K::Type& get(const Own& o) { return o.member; }                        \
+    }
+
+template<typename... F> struct Schema;
+
+template<> struct Schema<> {
+    static constexpr size_t count = 0, jsonBody = 0, mpBody = 0;
+    template<typename O> static void jsonFields(char*&, const O&, bool) {}
+    template<typename O> static void jsonFieldsSince(char*&, const O&, const uint32_t*, uint32_t, bool) {}
+    template<typename O> static void mpFields(uint8_t*&, const O&) {}
+    template<typename O> static void mpFieldsSince(uint8_t*&, const O&, const uint32_t*, uint32_t) {}
+    static size_t countSince(const uint32_t*, uint32_t) { return 0; }
+    template<typename O> static void diff(const O&, const O&, uint32_t*, uint32_t) {}
+};
+
+template<typename F, typename... R> struct Schema<F, R...> {
+    typedef typename F::Own Owner;
+    typedef Schema<R...> Rest;
+    static constexpr size_t count = 1 + sizeof...(R);
+    // ,"key":value per field (one comma too many: still an upper bound)
+    static constexpr size_t jsonBody = 1 + F::nameLen + 3 + F::K::jsonMax + Rest::jsonBody;
+    static constexpr size_t mpBody = mpStrHdr(F::nameLen) + F::nameLen + F::K::mpMax + Rest::mpBody;
+    static constexpr size_t jsonMax = 2 + jsonBody;            // {...}, NUL not included
+    static constexpr size_t mpMax = mpMapHdr(count) + mpBody;
+
+    static void jsonField(char*& p, const Owner& o, bool first) {
+        if (!first) *p++ = ',';
+        *p++ = '"';
+        memcpy(p, F::name(), F::nameLen);
+        p += F::nameLen;
+        *p++ = '"';
+        *p++ = ':';
+        F::K::json(p, F::get(o));
+    }
+    static void jsonFields(char*& p, const Owner& o, bool first) {
+        jsonField(p, o, first);
+        Rest::jsonFields(p, o, false);
+    }
+    static void mpField(uint8_t*& p, const Owner& o) {
+        p = mpStr(p, F::name(), F::nameLen);
+        F::K::msgpack(p, F::get(o));
+    }
+    static void mpFields(uint8_t*& p, const Owner& o) {
+        mpField(p, o);
+        Rest::mpFields(p, o);
+    }
+    // Only the fields whose ver[] slot (one per field, in order) is newer than since
+    static void jsonFieldsSince(char*& p, const Owner& o, const uint32_t* ver, uint32_t since, bool first) {
+        bool changed = *ver > since;
+        if (changed) jsonField(p, o, first);
+        Rest::jsonFieldsSince(p, o, ver + 1, since, first && !changed);
+    }
+    // MessagePack needs the entry count up front: countSince() of them, then mpFieldsSince()
+    static size_t countSince(const uint32_t* ver, uint32_t since) {
+        return (*ver > since ? 1 : 0) + Rest::countSince(ver + 1, since);
+    }
+    static void mpFieldsSince(uint8_t*& p, const Owner& o, const uint32_t* ver, uint32_t since) {
+        if (*ver > since) mpField(p, o);
+        Rest::mpFieldsSince(p, o, ver + 1, since);
+    }
+    // Stamps ver[] with v for every field that differs between a and b
+    static void diff(const Owner& a, const Owner& b, uint32_t* ver, uint32_t v) {
+        if (memcmp(&F::get(a), &F::get(b), sizeof(typename F::K::Type)) != 0) *ver = v;
+        Rest::diff(a, b, ver + 1, v);
+    }
+    static void writeJson(char*& p, const Owner& o) { *p++ = '{'; jsonFields(p, o, true); *p++ = '}'; }
+    static void writeMsgPack(uint8_t*& p, const Owner& o) { p = mpMap(p, count); mpFields(p, o); }
+
+    template<size_t N> static size_t toJson(const Owner& o, char (&out)[N]) {
+        static_assert(N >= jsonMax + 1, "buffer smaller than the schema's JSON bound");
+        char* p = out;
+        writeJson(p, o);
+        *p = '\0';
+        return p - out;
+    }
+    template<size_t N> static size_t toJsonSince(const Owner& o, const uint32_t (&ver)[count], uint32_t since, char (&out)[N]) {
+        static_assert(N >= jsonMax + 1, "buffer smaller than the schema's JSON bound");
+        char* p = out;
+        *p++ = '{';
+        jsonFieldsSince(p, o, ver, since, true);
+        *p++ = '}';
+        *p = '\0';
+        return p - out;
+    }
+    template<size_t N> static size_t toMsgPack(const Owner& o, uint8_t (&out)[N]) {
+        static_assert(N >= mpMax, "buffer smaller than the schema's MessagePack bound");
+        uint8_t* p = out;
+        writeMsgPack(p, o);
+        return p - out;
+    }
+};
+
+// Nested object, or null when absent
+template<typename T> struct Maybe {
+    bool has;
+    T v;
+};
+
+template<typename Sch> struct KMaybe {
+    typedef Maybe<typename Sch::Owner> Type;
+    static constexpr size_t jsonMax = cmax(4, Sch::jsonMax);
+    static constexpr size_t mpMax = cmax(1, Sch::mpMax);
+    static void json(char*& p, const Type& v) {
+        if (v.has) Sch::writeJson(p, v.v);
+        else { memcpy(p, "null", 4); p += 4; }
+    }
+    static void msgpack(uint8_t*& p, const Type& v) {
+        if (v.has) Sch::writeMsgPack(p, v.v);
+        else *p++ = 0xC0;
+    }
+};
+
+// TigerTag payload as sent to clients (layout of the former hand-written JSON)
+struct TagState {
+    uint32_t id, product, measure, ts, lastWeightTs;
+    uint16_t material, brand;
+    uint8_t  type, diameter, unit;
+    uint8_t  aspect[2];
+    uint16_t temp[2];
+    uint8_t  dry[2];
+    uint8_t  color[4];
+    int32_t  lastWeight;     // -1 = never written back
+};
+SCHEMA_FIELD(TagState, id,           KNum<uint32_t>,  "id");
+SCHEMA_FIELD(TagState, product,      KNum<uint32_t>,  "product");
+SCHEMA_FIELD(TagState, material,     KNum<uint16_t>,  "material");
+SCHEMA_FIELD(TagState, aspect,       KPair<uint8_t>,  "aspect");
+SCHEMA_FIELD(TagState, type,         KNum<uint8_t>,   "type");
+SCHEMA_FIELD(TagState, diameter,     KNum<uint8_t>,   "diameter");
+SCHEMA_FIELD(TagState, brand,        KNum<uint16_t>,  "brand");
+SCHEMA_FIELD(TagState, color,        KHex<4>,         "color");
+SCHEMA_FIELD(TagState, measure,      KNum<uint32_t>,  "measure");
+SCHEMA_FIELD(TagState, unit,         KNum<uint8_t>,   "unit");
+SCHEMA_FIELD(TagState, temp,         KPair<uint16_t>, "temp");
+SCHEMA_FIELD(TagState, dry,          KPair<uint8_t>,  "dry");
+SCHEMA_FIELD(TagState, ts,           KNum<uint32_t>,  "ts");
+SCHEMA_FIELD(TagState, lastWeight,   KNum<int32_t>,   "lastWeight");
+SCHEMA_FIELD(TagState, lastWeightTs, KNum<uint32_t>,  "lastWeightTs");
+typedef Schema<TagState_id, TagState_product, TagState_material, TagState_aspect, TagState_type,
+               TagState_diameter, TagState_brand, TagState_color, TagState_measure, TagState_unit,
+               TagState_temp, TagState_dry, TagState_ts, TagState_lastWeight, TagState_lastWeightTs> TagSchema;
+
+static void tagStateFrom(const TigerTagData& t, TagState& s) {
+    memset(&s, 0, sizeof(s));
+    s.id = t.tagId;
+    s.product = t.productId;
+    s.material = t.materialId;
+    s.aspect[0] = t.aspect1;
+    s.aspect[1] = t.aspect2;
+    s.type = t.typeId;
+    s.diameter = t.diameterId;
+    s.brand = t.brandId;
+    memcpy(s.color, t.rgba, sizeof(s.color));
+    s.measure = t.measure;
+    s.unit = t.unitId;
+    s.temp[0] = t.tempMin;
+    s.temp[1] = t.tempMax;
+    s.dry[0] = t.dryTemp;
+    s.dry[1] = t.dryTime;
+    s.ts = t.timestamp;
+    s.lastWeight = t.wbValid ? (int32_t)t.wbWeight : -1;
+    s.lastWeightTs = t.wbTime;
+}
+
+// Device state: everything /api/status reports. Compared with memcmp, so always memset before filling.
+struct DeviceState {
+    int32_t  weight;            // displayed weight (hold-aware, as on the OLED)
+    int32_t  rawWeightCg;       // centigrams, the resolution rawWeight is printed with
+    int32_t  smoothWeight;
+    int32_t  holdWeight;
+    bool     hold;
+    TagUid   uid;
+    char     wifi[33];
+    uint32_t ip;
+    char     mdns[40];
+    const char* cloud;
+    char     apiKey[96];
+    bool     apiValid;
+    char     displayName[64];
+    float    calibrationFactor;
+    bool     tagWriteBack;
+    uint32_t uptimeMs;          // set at serialisation, not compared
+    uint32_t uptimeS;
+    char     sendToCloud[8];
+    Maybe<TagState> tag;
+    uint32_t touch;             // statusTouch() generation, not serialised
+};
+SCHEMA_FIELD(DeviceState, weight,            KNum<int32_t>,     "weight");
+SCHEMA_FIELD(DeviceState, rawWeightCg,       KFixed<2>,         "rawWeight");
+SCHEMA_FIELD(DeviceState, smoothWeight,      KNum<int32_t>,     "smoothWeight");
+SCHEMA_FIELD(DeviceState, hold,              KBool,             "hold");
+SCHEMA_FIELD(DeviceState, holdWeight,        KNum<int32_t>,     "holdWeight");
+SCHEMA_FIELD(DeviceState, uid,               KUidDec,           "uid");
+struct DeviceState_uidHex : DeviceState_uid {     // same member under a second key
+    typedef KUidHex K;
+    static const char* name() { return "uid_hex"; }
+    static constexpr size_t nameLen = 7;
+};
+SCHEMA_FIELD(DeviceState, wifi,              KStr<33>,          "wifi");
+SCHEMA_FIELD(DeviceState, ip,                KIp4,              "ip");
+SCHEMA_FIELD(DeviceState, mdns,              KStr<40>,          "mdns");
+SCHEMA_FIELD(DeviceState, cloud,             KLabel<5>,         "cloud");
+SCHEMA_FIELD(DeviceState, apiKey,            KStr<96>,          "apiKey");
+SCHEMA_FIELD(DeviceState, apiValid,          KBool,             "apiValid");
+SCHEMA_FIELD(DeviceState, displayName,       KStr<64>,          "displayName");
+SCHEMA_FIELD(DeviceState, calibrationFactor, KFloat<4>,         "calibrationFactor");
+SCHEMA_FIELD(DeviceState, tagWriteBack,      KBool,             "tagWriteBack");
+SCHEMA_FIELD(DeviceState, uptimeMs,          KNum<uint32_t>,    "uptime_ms");
+SCHEMA_FIELD(DeviceState, uptimeS,           KNum<uint32_t>,    "uptime_s");
+SCHEMA_FIELD(DeviceState, sendToCloud,       KStr<8>,           "sendToCloud");
+SCHEMA_FIELD(DeviceState, tag,               KMaybe<TagSchema>, "tag");
+
+typedef Schema<DeviceState_weight, DeviceState_rawWeightCg, DeviceState_smoothWeight, DeviceState_hold,
+               DeviceState_holdWeight, DeviceState_uid, DeviceState_uidHex, DeviceState_wifi, DeviceState_ip,
+               DeviceState_mdns, DeviceState_cloud, DeviceState_apiKey, DeviceState_apiValid,
+               DeviceState_displayName, DeviceState_calibrationFactor, DeviceState_tagWriteBack,
+               DeviceState_uptimeMs, DeviceState_uptimeS, DeviceState_sendToCloud, DeviceState_tag> StatusSchema;
+#define STATUS_FIELD_RAW    1       // DeviceState_rawWeightCg's position in StatusSchema (fieldVersion[] index)
+
+// SSE deltas: subsets of the same state
+typedef Schema<DeviceState_weight>                          WeightEventSchema;
+typedef Schema<DeviceState_uid, DeviceState_uidHex>         UidEventSchema;
+typedef Schema<DeviceState_hold, DeviceState_holdWeight>    HoldEventSchema;
+typedef Schema<DeviceState_sendToCloud>                     SendEventSchema;
+
+// WS tag notifications
+struct TagEvent {
+    const char* type;
+    TagUid uid;
+    Maybe<TagState> tag;
+};
+SCHEMA_FIELD(TagEvent, type, KLabel<12>,        "type");
+SCHEMA_FIELD(TagEvent, uid,  KUidDec,           "uid");
+SCHEMA_FIELD(TagEvent, tag,  KMaybe<TagSchema>, "tag");
+typedef Schema<TagEvent_type, TagEvent_uid, TagEvent_tag> TagArrivedSchema;
+typedef Schema<TagEvent_type, TagEvent_uid>               TagRemovedSchema;
+
+// --- Status snapshot: /api/status serialised once per change, shared by REST, WS and SSE ---
+// The loop task refreshes the cheap DeviceState fields on every WS tick and re-serialises only when
+// one of them moved (strings such as SSID and API key are re-read only after statusTouch()). The
+// JSON lives in a small pool of static, ref-counted buffers sized by StatusSchema's bound: a reader
+// takes a reference to the current one and sends straight from it, so N clients polling cost one
+// serialisation, and a slow client only pins its own buffer while newer versions go to the others.
+//
+// version is a weak validator (ETag W/"<version>"): it moves when any field other than uptime changes,
+// and every field remembers the version it last changed in, which is what ?since=<version> uses.
+// It starts at a random value each boot so a validator from before a reboot never matches.
+#define STATUS_POOL 3
+
+struct StatusBuf {
+    uint32_t version;
+    uint16_t len;
+    uint8_t  refs;           // 1 while current + 1 per reader; guarded by gStatusMux
+    DeviceState state;       // what json was built from (MessagePack is encoded on demand from it)
+    uint32_t fieldVersion[StatusSchema::count];
+    char     etag[16];       // W/"<version>"
+    char     json[StatusSchema::jsonMax + 1];
+};
+
+StatusBuf gStatusPool[STATUS_POOL];
+StatusBuf* gStatusCur = nullptr;
+uint32_t gStatusVersion = 0;
+uint32_t gStatusBootVersion = 0;                    // first version of this boot
+uint32_t gStatusFieldVersion[StatusSchema::count];  // loop task only
+uint32_t gWsSentVersion = 0;                        // last version broadcast on /ws (loop task)
+DeviceState gStatusLast;     // loop task only
+volatile uint32_t gStatusTouch = 0;
+volatile bool gWsKick = false;                      // refresh and broadcast on the next loop pass
+portMUX_TYPE gStatusMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Call after changing a field the snapshot does not poll itself (strings, tag payload)
+void statusTouch() { gStatusTouch++; gWsKick = true; }
+
+// sendToCloud status: "3","2","1","send","success","error" or ""
+static const char* sendToCloudState(char (&buf)[8]) {
+    if (sendPhase == "countdown" && sendCountdown >= 0) { snprintf(buf, sizeof(buf), "%d", (int)sendCountdown); return buf; }
+    if (sendPhase == "send")    return "send";
+    if (sendPhase == "success") return "success";
+    if (sendPhase == "error")   return "error";
+    return "";
+}
+
+// Reference to the current snapshot (nullptr before the first build); pair with statusRelease()
+StatusBuf* statusAcquire() {
+    portENTER_CRITICAL(&gStatusMux);
+    StatusBuf* b = gStatusCur;
+    if (b) b->refs++;
+    portEXIT_CRITICAL(&gStatusMux);
+    return b;
+}
+
+void statusRelease(StatusBuf* b) {
+    portENTER_CRITICAL(&gStatusMux);
+    b->refs--;
+    portEXIT_CRITICAL(&gStatusMux);
+}
+
+template<size_t N> static void copyStr(char (&dst)[N], const char* src) {
+    memset(dst, 0, N);              // whole array: the state is compared with memcmp
+    strncpy(dst, src, N - 1);
+}
+
+static int32_t roundG(float w) { return (int32_t)(w + (w >= 0 ? 0.5f : -0.5f)); }
+
+// Fields that are cheap to read every tick
+static void stateFillLive(DeviceState& s, float displayed) {
+    s.weight = roundG(displayed);
+    s.rawWeightCg = roundG(currentWeight * 100.0f);
+    s.smoothWeight = roundG(currentWeight);
+    s.hold = holdMode;
+    s.holdWeight = roundG(holdWeight);
+    s.uid = lastUID;
+    s.cloud = cloudOK ? "ok" : "down";
+    s.apiValid = apiValid;
+    s.calibrationFactor = calibrationFactor;
+    s.tagWriteBack = tagWriteBack;
+    s.uptimeS = millis() / 1000;
+    char buf[8];
+    copyStr(s.sendToCloud, sendToCloudState(buf));
+    s.tag.has = gTagDataValid;
+    if (s.tag.has) tagStateFrom(gTagData, s.tag.v);
+    else memset(&s.tag.v, 0, sizeof(s.tag.v));
+}
+
+// String-backed fields: re-read only after statusTouch()
+static void stateFillStrings(DeviceState& s) {
+    copyStr(s.wifi, WiFi.SSID().c_str());
+    s.ip = (uint32_t)WiFi.localIP();
+    copyStr(s.mdns, (gMdnsName + ".local").c_str());
+    copyStr(s.apiKey, apiKey.c_str());
+    copyStr(s.displayName, apiDisplayName.c_str());
+}
+
+// Loop task. Returns true when a new version was published (uptime-only refreshes return false).
+bool statusRefresh(float displayed) {
+    DeviceState s;
+    memcpy(&s, &gStatusLast, sizeof(s));
+    stateFillLive(s, displayed);
+    uint32_t touch = gStatusTouch;
+    if (!gStatusCur || touch != s.touch) {
+        s.touch = touch;
+        stateFillStrings(s);
+    }
+    if (gStatusCur && memcmp(&s, &gStatusLast, sizeof(s)) == 0) return false;
+
+    // Uptime and the unrounded reading (EMA jitter at rest) ride along but are not changes of their own
+    uint32_t upS = s.uptimeS;
+    int32_t rawCg = s.rawWeightCg;
+    s.uptimeS = gStatusLast.uptimeS;
+    s.rawWeightCg = gStatusLast.rawWeightCg;
+    bool content = !gStatusCur || memcmp(&s, &gStatusLast, sizeof(s)) != 0;
+    s.uptimeS = upS;
+    s.rawWeightCg = rawCg;
+
+    // Claim a buffer nobody is reading; if every one is pinned, retry on the next tick
+    StatusBuf* b = nullptr;
+    portENTER_CRITICAL(&gStatusMux);
+    for (int i = 0; i < STATUS_POOL && !b; i++) {
+        if (gStatusPool[i].refs == 0) { b = &gStatusPool[i]; b->refs = 1; }
+    }
+    portEXIT_CRITICAL(&gStatusMux);
+    if (!b) return false;
+
+    if (!gStatusCur) gStatusVersion = gStatusBootVersion = esp_random() & 0x3FFFFFFF;
+    else if (content) gStatusVersion++;
+    s.uptimeMs = millis();          // snapshot time; carried over by the memcpy above, so never compared
+    StatusSchema::diff(s, gStatusLast, gStatusFieldVersion, gStatusVersion);
+    // rawWeight never bumps the version by itself: stamp it with every one so each delta carries it
+    gStatusFieldVersion[STATUS_FIELD_RAW] = gStatusVersion;
+    memcpy(&gStatusLast, &s, sizeof(s));
+
+    memcpy(&b->state, &s, sizeof(s));
+    memcpy(b->fieldVersion, gStatusFieldVersion, sizeof(b->fieldVersion));
+    b->version = gStatusVersion;
+    snprintf(b->etag, sizeof(b->etag), "W/\"%lu\"", (unsigned long)b->version);
+    b->len = StatusSchema::toJson(s, b->json);
+
+    portENTER_CRITICAL(&gStatusMux);
+    StatusBuf* old = gStatusCur;
+    gStatusCur = b;                 // keeps the claim reference as the "current" one
+    if (old) old->refs--;
+    portEXIT_CRITICAL(&gStatusMux);
+    return content;
+}
+
+static void statusHeaders(AsyncWebServerResponse* res, const StatusBuf* b) {
+    res->addHeader("ETag", b->etag);
+    res->addHeader("Cache-Control", "no-cache");
+    res->addHeader("Vary", "Accept");
+}
+
+// Streams a snapshot buffer without copying it into a String; drops its reference when the request ends
+class StatusResponse : public AsyncAbstractResponse {
+    StatusBuf* _buf;
+    size_t _sent;
+public:
+    explicit StatusResponse(StatusBuf* buf) : _buf(buf), _sent(0) {
+        _code = 200;
+        _contentType = "application/json";
+        _contentLength = buf->len;
+        statusHeaders(this, buf);
+    }
+    ~StatusResponse() { statusRelease(_buf); }
+    bool _sourceValid() const override { return true; }
+    size_t _fillBuffer(uint8_t *data, size_t maxLen) override {
+        size_t n = _contentLength - _sent;
+        if (n > maxLen) n = maxLen;
+        memcpy(data, _buf->json + _sent, n);
+        _sent += n;
+        return n;
+    }
+};
+
+AsyncWebSocket ws("/ws");
+
+// /ws status frames: {"seq":<version>, ...every field} on connect or resync, then
+// {"seq":<version>,"base":<previous seq>, ...fields changed since base} and, when idle,
+// a {"seq":<version>} heartbeat. A client whose last seq is older than base missed a frame
+// (AsyncWebSocket drops frames for a client whose queue is full) and asks for a resync.
+#define WS_HEARTBEAT_MS  15000
+const size_t WS_FRAME_LEN = StatusSchema::jsonBody + 40;   // + {"seq":..,"base":..} + } + NUL
+const size_t WS_MP_LEN = StatusSchema::mpMax + 24;         // + seq/base entries, map16 header
+
+// base == 0: every field
+static size_t wsFrame(char* out, const StatusBuf* b, uint32_t base) {
+    char* p = out + (base ? sprintf(out, "{\"seq\":%lu,\"base\":%lu", (unsigned long)b->version, (unsigned long)base)
+                          : sprintf(out, "{\"seq\":%lu", (unsigned long)b->version));
+    if (base) StatusSchema::jsonFieldsSince(p, b->state, b->fieldVersion, base, false);
+    else StatusSchema::jsonFields(p, b->state, false);
+    *p++ = '}';
+    *p = '\0';
+    return p - out;
+}
+
+// Same frame as a MessagePack map
+static size_t wsFrameMp(uint8_t* out, const StatusBuf* b, uint32_t base) {
+    uint8_t* p = mpMap(out, base ? 2 + StatusSchema::countSince(b->fieldVersion, base) : 1 + StatusSchema::count);
+    p = mpU32(mpStr(p, "seq", 3), b->version);
+    if (base) {
+        p = mpU32(mpStr(p, "base", 4), base);
+        StatusSchema::mpFieldsSince(p, b->state, b->fieldVersion, base);
+    } else {
+        StatusSchema::mpFields(p, b->state);
+    }
+    return p - out;
+}
+
+// --- /ws encodings: clients that open with Sec-WebSocket-Protocol: tigertag.msgpack get every frame
+// above (and every reply) as a MessagePack binary message; the others keep JSON text.
+// AsyncWebSocket echoes the offered protocol as is, so the client must offer that one alone.
+#define WS_SUBPROTO_MSGPACK  "tigertag.msgpack"
+#define WS_PEERS             6      // GOV_MAX_WS, plus closed clients cleanupClients() has not reaped yet
+
+struct WsPeer {
+    uint32_t id;        // 0 = free (AsyncWebSocket ids start at 1)
+    bool msgpack;
+};
+WsPeer gWsPeers[WS_PEERS];
+uint8_t gWsMsgpackPeers = 0;
+portMUX_TYPE gWsPeerMux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool wsPeerAdd(uint32_t id, bool msgpack) {
+    bool added = false;
+    portENTER_CRITICAL(&gWsPeerMux);
+    for (int i = 0; i < WS_PEERS && !added; i++) {
+        if (gWsPeers[i].id == 0) {
+            gWsPeers[i].id = id;
+            gWsPeers[i].msgpack = msgpack;
+            if (msgpack) gWsMsgpackPeers++;
+            added = true;
+        }
+    }
+    portEXIT_CRITICAL(&gWsPeerMux);
+    return added;
+}
+
+static void wsPeerRemove(uint32_t id) {
+    portENTER_CRITICAL(&gWsPeerMux);
+    for (int i = 0; i < WS_PEERS; i++) {
+        if (gWsPeers[i].id == id) {
+            if (gWsPeers[i].msgpack) gWsMsgpackPeers--;
+            gWsPeers[i].id = 0;
+        }
+    }
+    portEXIT_CRITICAL(&gWsPeerMux);
+}
+
+static bool wsIsMsgpack(uint32_t id) {
+    bool mp = false;
+    portENTER_CRITICAL(&gWsPeerMux);
+    for (int i = 0; i < WS_PEERS; i++) {
+        if (gWsPeers[i].id == id) mp = gWsPeers[i].msgpack;
+    }
+    portEXIT_CRITICAL(&gWsPeerMux);
+    return mp;
+}
+
+// To every client in its encoding. JSON-only audiences keep textAll()'s single shared buffer.
+static void wsBroadcast(const char* json, size_t jsonLen, const uint8_t* mp, size_t mpLen) {
+    if (gWsMsgpackPeers == 0) {
+        ws.textAll(json, jsonLen);
+        return;
+    }
+    WsPeer peers[WS_PEERS];
+    portENTER_CRITICAL(&gWsPeerMux);
+    memcpy(peers, gWsPeers, sizeof(peers));
+    portEXIT_CRITICAL(&gWsPeerMux);
+    for (int i = 0; i < WS_PEERS; i++) {
+        if (peers[i].id == 0) continue;
+        if (peers[i].msgpack) ws.binary(peers[i].id, (const char*)mp, mpLen);
+        else ws.text(peers[i].id, json, jsonLen);
+    }
+}
+
+static void wsBroadcastDoc(const JsonDocument& doc) {
+    char json[192];
+    uint8_t mp[192];
+    size_t jsonLen = serializeJson(doc, json, sizeof(json));
+    size_t mpLen = gWsMsgpackPeers ? serializeMsgPack(doc, mp, sizeof(mp)) : 0;
+    wsBroadcast(json, jsonLen, mp, mpLen);
+}
+
+// Reply to one client in its encoding
+static void wsSendDoc(AsyncWebSocketClient* client, const JsonDocument& doc) {
+    if (wsIsMsgpack(client->id())) {
+        uint8_t mp[192];
+        client->binary((const char*)mp, serializeMsgPack(doc, mp, sizeof(mp)));
+    } else {
+        char json[192];
+        client->text(json, serializeJson(doc, json, sizeof(json)));
+    }
+}
+
+static void wsSendFull(AsyncWebSocketClient* client) {
+    StatusBuf* b = statusAcquire();
+    if (!b) return;
+    if (wsIsMsgpack(client->id())) {
+        uint8_t frame[WS_MP_LEN];
+        size_t n = wsFrameMp(frame, b, 0);
+        statusRelease(b);
+        client->binary((const char*)frame, n);
+    } else {
+        char frame[WS_FRAME_LEN];
+        size_t n = wsFrame(frame, b, 0);
+        statusRelease(b);
+        client->text(frame, n);
+    }
+}
+
+// Loop task: status delta (or the full object when base is 0) to every client
+static void wsBroadcastStatus(const StatusBuf* b, uint32_t base) {
+    static char frame[WS_FRAME_LEN];
+    static uint8_t frameMp[WS_MP_LEN];
+    size_t n = wsFrame(frame, b, base);
+    size_t m = gWsMsgpackPeers ? wsFrameMp(frameMp, b, base) : 0;
+    wsBroadcast(frame, n, frameMp, m);
+}
+
+static void wsBroadcastBeat(uint32_t seq) {
+    char beat[24];
+    uint8_t beatMp[12];
+    size_t n = snprintf(beat, sizeof(beat), "{\"seq\":%lu}", (unsigned long)seq);
+    size_t m = mpU32(mpStr(mpMap(beatMp, 1), "seq", 3), seq) - beatMp;
+    wsBroadcast(beat, n, beatMp, m);
+}
+
+void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
+               AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    if (type == WS_EVT_CONNECT) {
+        // The upgrade request is still alive during this event: read the negotiated encoding off it
+        AsyncWebHeader* proto = ((AsyncWebServerRequest*)arg)->getHeader("Sec-WebSocket-Protocol");
+        bool msgpack = proto && proto->value().equals(WS_SUBPROTO_MSGPACK);
+        if (!wsPeerAdd(client->id(), msgpack)) {
+            client->close(1013, "busy");
+            return;
+        }
+        Serial.printf("WebSocket client #%u connected (%s)\n", client->id(), msgpack ? "msgpack" : "json");
+        // Send the current status snapshot so the UI updates right away on connect
+        wsSendFull(client);
+        // Also push current API status so the UI reflects it immediately on fresh load
+        {
+            StaticJsonDocument<192> out;
+            out["type"] = "apiStatus";
+            out["valid"] = apiValid;
+            if (apiValid && apiDisplayName.length()) out["displayName"] = apiDisplayName;
+            wsSendDoc(client, out);
+        }
+    } else if (type == WS_EVT_DISCONNECT) {
+        wsPeerRemove(client->id());
+    } else if (type == WS_EVT_DATA) {
+        AwsFrameInfo *info = (AwsFrameInfo*)arg;
+        // handle simple single-frame messages only; parsed in place, no String copy
+        if (!info->final || info->index != 0 || info->len != len) return;
+
+        StaticJsonDocument<256> doc;
+        DeserializationError err = info->opcode == WS_BINARY ? deserializeMsgPack(doc, (const char*)data, len)
+                                                             : deserializeJson(doc, (const char*)data, len);
+        if (err) {
+            Serial.printf("[WS] bad frame: %s\n", err.c_str());
+            return;
+        }
+        const char* mtype = doc["type"] | "";
+        if (strcmp(mtype, "resync") == 0) {
+            wsSendFull(client);
+        }
+        else if (strcmp(mtype, "updateApiKey") == 0) {
+            String newKey = String(doc["value"] | "");
+            newKey.trim();
+            StaticJsonDocument<192> out;
+            out["type"] = "apiStatus";
+            if (newKey.length() == 0) {
+                showToast(TOAST_ERROR, 1500, "API key FAIL", "Check key");
+                out["valid"] = false;
+                wsSendDoc(client, out);
+                return;
+            }
+            String displayName;
+            bool ok = validateApiKeyFirmware(newKey, displayName);
+            if (ok) {
+                // Persist only if valid
+                apiKey = newKey;
+                apiValid = true;
+                apiDisplayName = displayName;
+                statusTouch();
+                prefs.begin("config", false);
+                prefs.putString("apiKey", apiKey);
+                prefs.putString("apiName", apiDisplayName);
+                prefs.end();
+                // Notify UI
+                showToast(TOAST_OK, 1500, "API key OK", apiDisplayName);
+                out["valid"] = true;
+                out["displayName"] = apiDisplayName;
+                wsSendDoc(client, out);
+                // Optional: also echo the stored key (if UI needs to sync)
+                // client->text(String("{\"type\":\"apiKey\",\"value\":\"") + apiKey + "\"}");
+            } else {
+                showToast(TOAST_ERROR, 1500, "API key FAIL", "Check key");
+                out["valid"] = false;
+                wsSendDoc(client, out);
+            }
+        }
+        else if (strcmp(mtype, "deleteApiKey") == 0) {
+            bool ok = deleteApiKey();
+            showToast(ok ? TOAST_OK : TOAST_ERROR, 1500,
+                      ok ? "API key deleted" : "Delete failed", ok ? "Credentials cleared" : "Check storage");
+            // Inform only the requester about the result
+            {
+                StaticJsonDocument<96> out;
+                out["type"] = "deleteApiKeyResult";
+                out["success"] = ok;
+                wsSendDoc(client, out);
+            }
+            // Broadcast new API status to all clients
+            {
+                StaticJsonDocument<96> st;
+                st["type"] = "apiStatus";
+                st["valid"] = false;
+                wsBroadcastDoc(st);
+            }
+        }
+    }
+}
+
+// --- Server-Sent Events: read-only change feed for dashboards (/events) ---
+// Each change is one named event (weight, uid, hold, send) whose data reuses the /api/status keys.
+// The last SSE_BACKLOG events are kept so a reconnecting client (Last-Event-ID) gets exactly what it
+// missed; anything older, or an id from a previous boot, gets the status snapshot as a "state" event.
+#define SSE_BACKLOG   16
+const size_t SSE_DATA_LEN = cmax(cmax(WeightEventSchema::jsonMax, UidEventSchema::jsonMax),
+                                 cmax(HoldEventSchema::jsonMax, SendEventSchema::jsonMax)) + 1;
+
+struct SseEvent {
+    uint32_t id;
+    const char* type;   // string literal
+    char data[SSE_DATA_LEN];
+};
+
+AsyncEventSource events("/events");
+SseEvent gSseLog[SSE_BACKLOG];
+uint8_t  gSseLogCount = 0;
+uint32_t gSseId = 0;                       // id of the newest event; seeded per boot in setupEvents()
+portMUX_TYPE gSseMux = portMUX_INITIALIZER_UNLOCKED;
+
+DeviceState gSseLast;        // last published values (loop task only)
+bool gSseLastValid = false;
+
+// AsyncEventSource keeps its client list and per-client queues unlocked, and async_tcp changes them
+// (connect, ack, poll, timeout, disconnect) while the loop publishes. gSseLock serialises both sides:
+// the loop holds it around events.send(), async_tcp in every entry point rerouted below. Recursive:
+// a timeout closes the socket, which runs the disconnect callback in place.
+SemaphoreHandle_t gSseLock = NULL;
+
+static void ssePublish(const char* type, const char* data) {
+    portENTER_CRITICAL(&gSseMux);
+    uint32_t id = ++gSseId;
+    SseEvent& e = gSseLog[id % SSE_BACKLOG];
+    e.id = id;
+    e.type = type;
+    strlcpy(e.data, data, sizeof(e.data));
+    if (gSseLogCount < SSE_BACKLOG) gSseLogCount++;
+    portEXIT_CRITICAL(&gSseMux);
+    xSemaphoreTakeRecursive(gSseLock, portMAX_DELAY);
+    if (events.count() > 0) events.send(data, type, id);
+    xSemaphoreGiveRecursive(gSseLock);
+}
+
+// Diff the live state against what was last published and emit one event per changed field.
+void sseSync(float displayed) {
+    DeviceState now;
+    memset(&now, 0, sizeof(now));
+    stateFillLive(now, displayed);
+    char data[SSE_DATA_LEN];
+    if (!gSseLastValid || now.weight != gSseLast.weight) {
+        WeightEventSchema::toJson(now, data);
+        ssePublish("weight", data);
+    }
+    if (!gSseLastValid || now.uid != gSseLast.uid) {
+        UidEventSchema::toJson(now, data);
+        ssePublish("uid", data);
+    }
+    if (!gSseLastValid || now.hold != gSseLast.hold || (now.hold && now.holdWeight != gSseLast.holdWeight)) {
+        HoldEventSchema::toJson(now, data);
+        ssePublish("hold", data);
+    }
+    if (!gSseLastValid || strcmp(now.sendToCloud, gSseLast.sendToCloud) != 0) {
+        SendEventSchema::toJson(now, data);
+        ssePublish("send", data);
+    }
+    gSseLast = now;
+    gSseLastValid = true;
+}
+
+// async_tcp task, gSseLock held: the library's socket callbacks again, each one under the lock
+static void sseGuardClient(AsyncEventSourceClient* client) {
+    AsyncClient* c = client->client();
+    c->onAck([](void* r, AsyncClient*, size_t len, uint32_t time) {
+        xSemaphoreTakeRecursive(gSseLock, portMAX_DELAY);
+        ((AsyncEventSourceClient*)r)->_onAck(len, time);
+        xSemaphoreGiveRecursive(gSseLock);
+    }, client);
+    c->onPoll([](void* r, AsyncClient*) {
+        xSemaphoreTakeRecursive(gSseLock, portMAX_DELAY);
+        ((AsyncEventSourceClient*)r)->_onPoll();
+        xSemaphoreGiveRecursive(gSseLock);
+    }, client);
+    c->onTimeout([](void* r, AsyncClient*, uint32_t time) {
+        xSemaphoreTakeRecursive(gSseLock, portMAX_DELAY);
+        ((AsyncEventSourceClient*)r)->_onTimeout(time);
+        xSemaphoreGiveRecursive(gSseLock);
+    }, client);
+    c->onDisconnect([](void* r, AsyncClient* c) {
+        xSemaphoreTakeRecursive(gSseLock, portMAX_DELAY);
+        ((AsyncEventSourceClient*)r)->_onDisconnect();     // unlinks and frees the client
+        xSemaphoreGiveRecursive(gSseLock);
+        delete c;
+    }, client);
+}
+
+// Runs on the async_tcp task (gSseLock held): replay from the backlog when the gap is covered, else send a snapshot.
+static void onEventsConnect(AsyncEventSourceClient *client) {
+    sseGuardClient(client);
+    uint32_t last = client->lastId();
+    portENTER_CRITICAL(&gSseMux);
+    uint32_t newest = gSseId;
+    uint32_t oldest = newest - gSseLogCount + 1;
+    portEXIT_CRITICAL(&gSseMux);
+
+    if (last != 0 && last <= newest && last + 1 >= oldest) {
+        for (uint32_t id = last + 1; id <= newest; id++) {
+            SseEvent e;
+            portENTER_CRITICAL(&gSseMux);
+            e = gSseLog[id % SSE_BACKLOG];
+            portEXIT_CRITICAL(&gSseMux);
+            if (e.id != id) break;           // overwritten while replaying: client will get newer live events
+            client->send(e.data, e.type, e.id);
+        }
+        return;
+    }
+    // Full snapshot: the shared /api/status body, tagged with the newest id so the next resume works
+    StatusBuf* b = statusAcquire();
+    if (!b) return;
+    client->send(b->json, "state", newest, 2000);
+    statusRelease(b);
+}
+
+// The client is created (and onEventsConnect run) from the response's first ack: do that under the lock
+class SseResponse : public AsyncEventSourceResponse {
+public:
+    SseResponse() : AsyncEventSourceResponse(&events) {}
+    size_t _ack(AsyncWebServerRequest *request, size_t len, uint32_t time) override {
+        xSemaphoreTakeRecursive(gSseLock, portMAX_DELAY);
+        size_t n = AsyncEventSourceResponse::_ack(request, len, time);   // may free this response
+        xSemaphoreGiveRecursive(gSseLock);
+        return n;
+    }
+};
+
+// Serves /events in place of `events` itself (its handler is final), so connects go through SseResponse
+class SseHandler : public AsyncWebHandler {
+public:
+    bool canHandle(AsyncWebServerRequest *request) override {
+        if (request->method() != HTTP_GET || !request->url().equals(events.url())) return false;
+        request->addInterestingHeader("Last-Event-ID");
+        return true;
+    }
+    void handleRequest(AsyncWebServerRequest *request) override {
+        request->send(new SseResponse());
+    }
+};
+SseHandler gSseHandler;
+
+void setupEvents() {
+    // Ids must not repeat across reboots, or a stale Last-Event-ID would replay the wrong events.
+    // Last-Event-ID is parsed with atoi(): stay well below INT32_MAX.
+    gSseId = esp_random() & 0x3FFFFFFF;
+    gSseLock = xSemaphoreCreateRecursiveMutex();
+    events.onConnect(onEventsConnect);
+    server.addHandler(&gSseHandler);
+}
+
+// --- Long-poll: GET /api/wait-stable parks until the scale settles (hold) with the wanted tag ---
+// The handler parks the request in a slot and answers at once with a chunked response whose filler
+// returns RESPONSE_TRY_AGAIN (the library retries on every ack/poll) until the loop has written the
+// reply into the slot: when the hold detector reports a settled weight (>= MIN_WEIGHT_TO_SEND_G) for
+// a matching UID, or at the deadline. Each settle bumps gStableSeq; ?after=<seq> waits for a newer
+// one than a previous reply, otherwise a hold already in progress answers at once. Only async_tcp
+// touches the request (filler, onDisconnect); the loop only writes slot data, under the mutex.
+// Latency: an idle connection gets no acks, so the filler next runs on AsyncTCP's poll (tcp_poll
+// interval 1 = one 500 ms lwIP slow tick): the reply leaves up to LONGPOLL_WAKE_MS after the settle.
+// Waking async_tcp sooner would mean calling into the pcb from another task, which races its teardown.
+#define LONGPOLL_WAKE_MS      500       // worst-case delay added to a reply; timeouts are filled this early
+#define LONGPOLL_MAX          4
+#define LONGPOLL_DEFAULT_MS   30000UL
+#define LONGPOLL_MAX_MS       120000UL
+#define GOV_RETRY_S           "2"       // Retry-After on 503 (here and in the admission gate)
+
+struct StableReply {
+    bool     stable;
+    int32_t  weight;
+    TagUid   uid;
+    uint32_t seq;
+};
+SCHEMA_FIELD(StableReply, stable, KBool,          "stable");
+SCHEMA_FIELD(StableReply, weight, KNum<int32_t>,  "weight");
+SCHEMA_FIELD(StableReply, uid,    KUidDec,        "uid");
+SCHEMA_FIELD(StableReply, seq,    KNum<uint32_t>, "seq");
+typedef Schema<StableReply_stable, StableReply_weight, StableReply_uid, StableReply_seq> StableSchema;
+
+struct LongPoll {
+    AsyncWebServerRequest* request;     // nullptr = free
+    char     uid[UID_DEC_LEN];          // decimal, as the UI/cloud see it; "" = any tag (or none)
+    uint32_t after;
+    uint32_t deadlineMs;
+    uint8_t  len;                       // reply length, 0 = still waiting
+    char     reply[StableSchema::jsonMax + 1];   // written by the loop
+};
+
+LongPoll gLongPolls[LONGPOLL_MAX];
+SemaphoreHandle_t gLongPollMutex = NULL;
+uint32_t gStableSeq = 0;                // bumped by loop() on every hold entry
+
+// async_tcp task: the request is about to be freed
+void longPollForget(AsyncWebServerRequest* request) {
+    xSemaphoreTake(gLongPollMutex, portMAX_DELAY);
+    for (int i = 0; i < LONGPOLL_MAX; i++) {
+        if (gLongPolls[i].request == request) gLongPolls[i].request = nullptr;
+    }
+    xSemaphoreGive(gLongPollMutex);
+}
+
+static bool uidIs(const TagUid& u, const char* dec) {
+    char s[UID_DEC_LEN];
+    return !u.empty() && strcmp(u.toDec(s), dec) == 0;
+}
+
+// Loop task, mutex held: the filler picks the reply up on async_tcp
+static void longPollReply(LongPoll& lp, bool stable, const TagUid& uid) {
+    StableReply r;
+    r.stable = stable;
+    r.weight = stable ? roundG(holdWeight) : 0;
+    r.uid = uid;
+    r.seq = gStableSeq;
+    lp.len = StableSchema::toJson(r, lp.reply);
+}
+
+// async_tcp task: chunked filler of a parked request
+static size_t longPollFill(AsyncWebServerRequest* request, int slot, uint8_t* buf, size_t maxLen, size_t index) {
+    if (index) return 0;                // reply sent: terminating chunk
+    size_t n = RESPONSE_TRY_AGAIN;
+    xSemaphoreTake(gLongPollMutex, portMAX_DELAY);
+    LongPoll& lp = gLongPolls[slot];
+    if (lp.request == request && lp.len && lp.len <= maxLen) {
+        n = lp.len;
+        memcpy(buf, lp.reply, n);
+        lp.request = nullptr;
+    }
+    xSemaphoreGive(gLongPollMutex);
+    return n;
+}
+
+// Loop task, every pass
+void longPollService() {
+    const uint32_t now = millis();
+    const bool settled = holdMode && holdWeight >= MIN_WEIGHT_TO_SEND_G;
+    xSemaphoreTake(gLongPollMutex, portMAX_DELAY);
+    for (int i = 0; i < LONGPOLL_MAX; i++) {
+        LongPoll& lp = gLongPolls[i];
+        if (!lp.request || lp.len) continue;
+        TagUid hit = {};
+        bool match = false;
+        if (settled && gStableSeq > lp.after) {
+            if (!lp.uid[0])                                { match = true; hit = !lastUID.empty() ? lastUID : gTagUid; }
+            else if (uidIs(lastUID, lp.uid))               { match = true; hit = lastUID; }
+            else if (gTagPresent && uidIs(gTagUid, lp.uid)) { match = true; hit = gTagUid; }
+        }
+        if (match) longPollReply(lp, true, hit);
+        else if ((int32_t)(now + LONGPOLL_WAKE_MS - lp.deadlineMs) >= 0) longPollReply(lp, false, TagUid());
+    }
+    xSemaphoreGive(gLongPollMutex);
+}
+
+void handleWaitStable(AsyncWebServerRequest* request) {
+    LongPoll lp;
+    lp.request = request;
+    lp.after = request->hasParam("after") ? strtoul(request->getParam("after")->value().c_str(), NULL, 10) : 0;
+    uint32_t timeout = request->hasParam("timeout") ? strtoul(request->getParam("timeout")->value().c_str(), NULL, 10) : LONGPOLL_DEFAULT_MS;
+    if (timeout > LONGPOLL_MAX_MS) timeout = LONGPOLL_MAX_MS;
+    lp.deadlineMs = millis() + timeout;
+    lp.len = 0;
+    String uid = request->hasParam("uid") ? request->getParam("uid")->value() : String();
+    bool digits = uid.length() < UID_DEC_LEN;
+    for (unsigned i = 0; digits && i < uid.length(); i++) digits = isdigit((unsigned char)uid[i]);
+    if (!digits) {
+        request->send(400, "application/json", "{\"error\":\"uid must be decimal\"}");
+        return;
+    }
+    strlcpy(lp.uid, uid.c_str(), sizeof(lp.uid));
+    int slot = -1;
+    xSemaphoreTake(gLongPollMutex, portMAX_DELAY);
+    for (int i = 0; i < LONGPOLL_MAX && slot < 0; i++) {
+        if (!gLongPolls[i].request) { gLongPolls[i] = lp; slot = i; }
+    }
+    xSemaphoreGive(gLongPollMutex);
+    if (slot < 0) {
+        AsyncWebServerResponse* res = request->beginResponse(503, "application/json", "{\"error\":\"busy\"}");
+        res->addHeader("Retry-After", GOV_RETRY_S);
+        request->send(res);
+        return;
+    }
+    // Filled by longPollService(), or the slot is dropped by longPollForget() on disconnect
+    AsyncWebServerResponse* res = request->beginChunkedResponse("application/json",
+        [request, slot](uint8_t* buf, size_t maxLen, size_t index) -> size_t {
+            return longPollFill(request, slot, buf, maxLen, index);
+        });
+    res->addHeader("Cache-Control", "no-store");
+    request->send(res);
+}
+
+// --- Admission control: caps clients and sheds work by priority before the heap runs out ---
+// AsyncWebServer allocates a request, its headers and its response per connection, and every WS
+// client queues up to WS_MAX_QUEUED_MESSAGES frames. The gate is the first handler: it sees each
+// request once its headers are parsed and either lets it through (returns false) or claims it
+// and answers 503. Static assets go first, API reads next; writes (tare, push, config) are kept
+// until the heap is nearly exhausted.
+#define GOV_MAX_HTTP    6       // concurrent HTTP requests (high priority may exceed)
+#define GOV_MAX_WS      4       // WebSocket clients
+#define GOV_MAX_SSE     4       // /events clients
+
+enum ReqPrio { PRIO_LOW, PRIO_NORMAL, PRIO_HIGH };
+
+// Admission floors per priority: free heap and largest free block (fragmentation) in bytes
+struct HeapFloor { uint32_t freeHeap; uint32_t maxBlock; };
+const HeapFloor GOV_FLOOR[3] = {
+    { 40000, 16384 },   // PRIO_LOW    : static assets
+    { 24000,  8192 },   // PRIO_NORMAL : API reads, WS/SSE connects, periodic WS broadcasts
+    { 12000,  4096 },   // PRIO_HIGH   : API writes
+};
+
+struct GovStats {
+    uint32_t admitted;
+    uint32_t rejectedHeap[3];   // per ReqPrio
+    uint32_t rejectedBusy;      // GOV_MAX_HTTP reached
+    uint32_t rejectedWs;
+    uint32_t rejectedSse;
+    uint32_t wsShed;            // periodic WS broadcasts skipped under memory pressure
+    uint32_t minFreeHeap;
+    uint32_t minMaxBlock;
+    uint16_t httpPeak;
+};
+GovStats gGov = {0, {0, 0, 0}, 0, 0, 0, 0, UINT32_MAX, UINT32_MAX, 0};
+uint16_t gHttpInFlight = 0;     // async_tcp task only
+
+static bool heapAllows(ReqPrio p) {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t maxBlock = ESP.getMaxAllocHeap();
+    if (freeHeap < gGov.minFreeHeap) gGov.minFreeHeap = freeHeap;
+    if (maxBlock < gGov.minMaxBlock) gGov.minMaxBlock = maxBlock;
+    return freeHeap >= GOV_FLOOR[p].freeHeap && maxBlock >= GOV_FLOOR[p].maxBlock;
+}
+
+static ReqPrio requestPrio(AsyncWebServerRequest *request) {
+    if (!request->url().startsWith("/api")) return PRIO_LOW;
+    return request->method() == HTTP_GET ? PRIO_NORMAL : PRIO_HIGH;
+}
+
+class AdmissionGate : public AsyncWebHandler {
+public:
+    // true = reject (handleRequest answers 503), false = let the next handler take it
+    bool canHandle(AsyncWebServerRequest *request) override {
+        if (request->isExpectedRequestedConnType(RCT_WS)) {
+            if (ws.count() < GOV_MAX_WS && heapAllows(PRIO_NORMAL)) return false;
+            gGov.rejectedWs++;
+            return true;
+        }
+        if (request->isExpectedRequestedConnType(RCT_EVENT)) {
+            if (events.count() < GOV_MAX_SSE && heapAllows(PRIO_NORMAL)) return false;
+            gGov.rejectedSse++;
+            return true;
+        }
+        ReqPrio p = requestPrio(request);
+        if (!heapAllows(p)) {
+            gGov.rejectedHeap[p]++;
+            return true;
+        }
+        // Parked long-polls are capped by their own slots, not by GOV_MAX_HTTP
+        bool counted = !request->url().equals("/api/wait-stable");
+        if (counted && p != PRIO_HIGH && gHttpInFlight >= GOV_MAX_HTTP) {
+            gGov.rejectedBusy++;
+            return true;
+        }
+        // WS/SSE upgrades hand their socket over and never fire this: only plain HTTP is counted
+        if (counted) {
+            gHttpInFlight++;
+            if (gHttpInFlight > gGov.httpPeak) gGov.httpPeak = gHttpInFlight;
+        }
+        gGov.admitted++;
+        request->onDisconnect([request, counted]() {
+            if (counted) gHttpInFlight--;
+            longPollForget(request);
+        });
+        return false;
+    }
+
+    void handleRequest(AsyncWebServerRequest *request) override {
+        AsyncWebServerResponse *res = request->beginResponse(503, "application/json", "{\"error\":\"busy\"}");
+        res->addHeader("Retry-After", GOV_RETRY_S);
+        res->addHeader("Cache-Control", "no-store");
+        request->send(res);
+    }
+};
+AdmissionGate gAdmission;
+
+// ============================================
+// API operations: shared by the REST routes and POST /api/batch
+// ============================================
+// Each returns the HTTP status and JSON body the route would send; parsing stays in the route.
+struct ApiResult {
+    int code;
+    String body;
+};
+
+ApiResult opConfig(const String& key) {
+    apiKey = key;
+    statusTouch();
+    prefs.begin("config", false);
+    prefs.putString("apiKey", apiKey);
+    prefs.end();
+    return {200, "{\"status\":\"ok\"}"};
+}
+
+ApiResult opTare() {
+    scale.tare();
+    currentWeight = 0.0f;
+    gWsKick = true;
+    return {200, "{\"status\":\"ok\"}"};
+}
+
+ApiResult opCalibration(float f) {
+    if (f == 0.0f || !std::isfinite(f)) return {400, "{\"error\":\"invalid factor\"}"};
+    calibrationFactor = f;
+    scale.set_scale(calibrationFactor);
+    prefs.begin("config", false);
+    prefs.putFloat("calFactor", calibrationFactor);
+    prefs.end();
+    return {200, "{\"status\":\"ok\"}"};
+}
+
+#define PUSH_ERR_BODY_MAX   128     // upstream body echoed in a 502, escaped
+
+// Blocking (cloud round-trip), like the route always was. uidDec: decimal UID, nullptr = the tag on the scale.
+ApiResult opPushWeight(int wi, const char* uidDec) {
+    char uidBuf[UID_DEC_LEN];
+    if (!uidDec) uidDec = lastUID.toDec(uidBuf);   // "" without a tag
+    if (apiKey.length() == 0) return {400, "{\"error\":\"missing apiKey\"}"};
+    if (!uidDec[0]) return {400, "{\"error\":\"missing uid (present a tag)\"}"};
+
+    HTTPClient http;
+    const char* url = "https://us-central1-tigertag-connect.cloudfunctions.net/setSpoolWeightByRfid";
+    if (!http.begin(url)) return {500, "{\"error\":\"http begin failed\"}"};
+    http.addHeader("Content-Type", "application/json");
+    http.addHeader("x-api-key", apiKey);
+    char payload[64];
+    int plen = snprintf(payload, sizeof(payload), "{\"uid\":\"%s\",\"weight\":%d}", uidDec, wi);
+    int code = http.POST((uint8_t*)payload, plen);
+    String resp = http.getString();
+    http.end();
+
+    if (code >= 200 && code < 300) {
+        currentWeight = (float)wi;
+        showToast(TOAST_OK, 1500, "Synced \xE2\x9C\x93", String(wi) + " g", "to cloud");
+        lastUID.clear();
+        lastPushedWeight = NAN;
+        stableSinceMs = 0;
+        stableCandidate = NAN;
+        gWsKick = true;
+        displayWeight(currentWeight, lastUID);
+        return {200, "{\"status\":\"ok\"}"};
+    }
+    // The upstream body goes inside our JSON (and inside /api/batch results): escape it
+    char err[40 + 6 * PUSH_ERR_BODY_MAX];
+    char* p = err + snprintf(err, 40, "{\"error\":\"upstream %d\",\"body\":", code);
+    p = jsonStr(p, resp.c_str(), PUSH_ERR_BODY_MAX);
+    *p++ = '}';
+    *p = '\0';
+    return {502, String(err)};
+}
+
+// Built on the spot rather than from the loop's snapshot, so a batch reads back what its earlier ops changed
+ApiResult opStatus() {
+    DeviceState s;
+    memset(&s, 0, sizeof(s));
+    stateFillLive(s, holdMode ? holdWeight : currentWeight);
+    stateFillStrings(s);
+    s.uptimeMs = millis();
+    char json[StatusSchema::jsonMax + 1];
+    StatusSchema::toJson(s, json);
+    return {200, String(json)};
+}
+
+// ============================================
+// POST /api/batch: several operations, one request
+// ============================================
+// { "ops": [ {"op":"tare"}, {"op":"calibration","factor":406.5}, {"op":"status"},
+//            {"op":"push","weight":1234}, {"op":"config","apiKey":"..."} ] }
+// Runs in order and stops at the first failure; later ops report "skipped". Always 200: the
+// per-op "code" is what the single route would have answered, "result" its body.
+#define BATCH_MAX_OPS    8
+#define BATCH_MAX_BODY   1024
+
+static ApiResult batchRun(JsonObjectConst op) {
+    const char* name = op["op"] | "";
+    if (!strcmp(name, "tare")) return opTare();
+    if (!strcmp(name, "status")) return opStatus();
+    if (!strcmp(name, "calibration")) {
+        JsonVariantConst f = op.containsKey("factor") ? op["factor"] : op["value"];
+        if (!f.is<float>()) return {400, "{\"error\":\"missing factor/value\"}"};
+        return opCalibration(f.as<float>());
+    }
+    if (!strcmp(name, "push")) {
+        // no weight: the one on the display
+        float w = op["weight"].is<float>() ? op["weight"].as<float>() : currentWeight;
+        if (w <= 0) return {400, "{\"error\":\"invalid weight\"}"};
+        return opPushWeight((int)(w + 0.5f), nullptr);
+    }
+    if (!strcmp(name, "config")) {
+        if (!op["apiKey"].is<const char*>()) return {400, "{\"error\":\"missing apiKey\"}"};
+        return opConfig(op["apiKey"].as<const char*>());
+    }
+    return {400, "{\"error\":\"unknown op\"}"};
+}
 
-void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
-               AwsEventType type, void *arg, uint8_t *data, size_t len) {
-    if (type == WS_EVT_CONNECT) {
-        Serial.printf("WebSocket client #%u connected\n", client->id());
-        // Send an immediate snapshot so the UI updates right away on connect
-        int wIntSnap = (int)(currentWeight + (currentWeight >= 0 ? 0.5f : -0.5f));
-        char snap[96];
-        snprintf(snap, sizeof(snap), "{\"weight\":%d,\"uid\":\"%s\"}", wIntSnap, lastUID.c_str());
-        client->text(snap);
-        // Also push current API status so the UI reflects it immediately on fresh load
-        {
-            StaticJsonDocument<192> out;
-            out["type"] = "apiStatus";
-            out["valid"] = apiValid;
-            if (apiValid && apiDisplayName.length()) out["displayName"] = apiDisplayName;
-            String outStr; serializeJson(out, outStr);
-            client->text(outStr);
-        }
-    } else if (type == WS_EVT_DATA) {
-        AwsFrameInfo *info = (AwsFrameInfo*)arg;
-        if (!info->final || info->opcode != WS_TEXT) return; // handle simple single-frame text only
-        String msg = String((const char*)data).substring(0, len);
+void handleBatch(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    // Single-chunk bodies only, like every other route here
+    if (index != 0 || len != total || total > BATCH_MAX_BODY) {
+        if (index == 0) request->send(413, "application/json", "{\"error\":\"body too large\"}");
+        return;
+    }
+    StaticJsonDocument<1536> doc;   // 8 ops of up to 3 members, plus copies of their strings
+    if (deserializeJson(doc, (const char*)data, len) || !doc["ops"].is<JsonArrayConst>()) {
+        request->send(400, "application/json", "{\"error\":\"expected {\\\"ops\\\":[...]}\"}");
+        return;
+    }
+    JsonArrayConst ops = doc["ops"].as<JsonArrayConst>();
+    if (ops.size() == 0 || ops.size() > BATCH_MAX_OPS) {
+        request->send(400, "application/json", "{\"error\":\"1 to 8 ops\"}");
+        return;
+    }
 
-        StaticJsonDocument<256> doc;
-        DeserializationError err = deserializeJson(doc, msg);
-        if (err) {
-            Serial.printf("[WS] bad JSON: %s\n", err.c_str());
-            return;
-        }
-        const char* mtype = doc["type"] | "";
-        if (strcmp(mtype, "updateApiKey") == 0) {
-            String newKey = String(doc["value"] | "");
-            newKey.trim();
-            if (newKey.length() == 0) {
-                displayMessage("API key FAIL", "Check key");
-                delay(600);
-                displayWeight(currentWeight, lastUID);
-                client->text("{\"type\":\"apiStatus\",\"valid\":false}");
-                return;
-            }
-            String displayName;
-            bool ok = validateApiKeyFirmware(newKey, displayName);
-            if (ok) {
-                // Persist only if valid
-                apiKey = newKey;
-                apiValid = true;
-                apiDisplayName = displayName;
-                prefs.begin("config", false);
-                prefs.putString("apiKey", apiKey);
-                prefs.putString("apiName", apiDisplayName);
-                prefs.end();
-                // Notify UI
-                displayMessage("API key OK", apiDisplayName);
-                delay(600);
-                displayWeight(currentWeight, lastUID);
-                StaticJsonDocument<192> out;
-                out["type"] = "apiStatus";
-                out["valid"] = true;
-                out["displayName"] = apiDisplayName;
-                String outStr; serializeJson(out, outStr);
-                client->text(outStr);
-                // Optional: also echo the stored key (if UI needs to sync)
-                // client->text(String("{\"type\":\"apiKey\",\"value\":\"") + apiKey + "\"}");
-            } else {
-                displayMessage("API key FAIL", "Check key");
-                delay(600);
-                displayWeight(currentWeight, lastUID);
-                client->text("{\"type\":\"apiStatus\",\"valid\":false}");
-            }
-        }
-        else if (strcmp(mtype, "deleteApiKey") == 0) {
-            bool ok = deleteApiKey();
-            displayMessage(ok ? "API key deleted" : "Delete failed", ok ? "Credentials cleared" : "Check storage");
-            delay(600);
-            displayWeight(currentWeight, lastUID);
-            // Inform only the requester about the result
-            {
-                StaticJsonDocument<96> out;
-                out["type"] = "deleteApiKeyResult";
-                out["success"] = ok;
-                String outStr; serializeJson(out, outStr);
-                client->text(outStr);
-            }
-            // Broadcast new API status to all clients
-            {
-                StaticJsonDocument<96> st;
-                st["type"] = "apiStatus";
-                st["valid"] = false;
-                String s; serializeJson(st, s);
-                ws.textAll(s);
-            }
+    AsyncResponseStream* res = request->beginResponseStream("application/json", 512);
+    res->addHeader("Cache-Control", "no-store");
+    res->print("{\"results\":[");
+    bool failed = false;
+    size_t i = 0;
+    for (JsonObjectConst op : ops) {
+        if (i++) res->print(',');
+        res->print("{\"op\":\"");
+        const char* name = op["op"] | "";
+        for (const char* c = name; *c; c++) if (*c != '"' && *c != '\\' && (uint8_t)*c >= 0x20) res->print(*c);
+        if (failed) {
+            res->print("\",\"skipped\":true}");
+            continue;
         }
+        ApiResult r = batchRun(op);
+        failed = r.code < 200 || r.code >= 300;
+        res->printf("\",\"code\":%d,\"result\":", r.code);
+        res->print(r.body);
+        res->print('}');
     }
+    res->printf("],\"ok\":%s}", failed ? "false" : "true");
+    request->send(res);
 }
 
 // ============================================
 // SERVEUR WEB & API
 // ============================================
 void setupWebServer() {
+    server.addHandler(&gAdmission);     // must stay first: sees every request before its handler
     ws.onEvent(onWsEvent);
     server.addHandler(&ws);
-    
-
-    // ============================================
-    // Page principale (préférer index.html.gz si présent)
-    // ============================================
-    // 🔎 Routing: Serve index.html(.gz) for root, with no-cache headers for fast dev iteration.
-    //    Tries .gz first for compressed transfer. Caching is disabled for HTML to ensure the UI updates immediately after changes.
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (LittleFS.exists("/www/index.html.gz")) {
-            AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/www/index.html.gz", "text/html; charset=utf-8");
-            response->addHeader("Content-Encoding", "gzip");
-            response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
-            response->addHeader("Pragma", "no-cache");
-            request->send(response);
-            return;
-        }
-        if (LittleFS.exists("/www/index.html")) {
-            AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/www/index.html", "text/html; charset=utf-8");
-            response->addHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
-            response->addHeader("Pragma", "no-cache");
-            request->send(response);
-            return;
-        }
-        request->send(404, "text/plain", "index.html(.gz) not found - uploadfs required");
-    });
-    
-    // CSS (style.css, fallback to .gz), cache 24h
-    // 🔎 Routing: Serve CSS, prefer uncompressed for debugging, fallback to .gz.
-    //    Caching enabled (24h) as CSS changes infrequently.
-    server.on("/style.css", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (LittleFS.exists("/www/style.css")) {
-            AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/www/style.css", "text/css");
-            response->addHeader("Cache-Control", "max-age=86400");
-            request->send(response);
-            return;
-        }
-        if (LittleFS.exists("/www/style.css.gz")) {
-            AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/www/style.css.gz", "text/css");
-            response->addHeader("Content-Encoding", "gzip");
-            response->addHeader("Cache-Control", "max-age=86400");
-            request->send(response);
-            return;
-        }
-        request->send(404, "text/plain", "style.css(.gz) not found");
-    });
-    server.serveStatic("/styles.css", LittleFS, "/www/styles.css").setCacheControl("no-store");
-    
-    // JavaScript (app.js, fallback to .gz), no-store
-    // 🔎 Routing: Serve JavaScript, prefer uncompressed for debugging, fallback to .gz.
-    //    Caching disabled (no-store) to ensure new code is always loaded.
-    server.on("/app.js", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (LittleFS.exists("/www/app.js")) {
-            AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/www/app.js", "application/javascript");
-            response->addHeader("Cache-Control", "no-store");
-            request->send(response);
-            return;
-        }
-        if (LittleFS.exists("/www/app.js.gz")) {
-            AsyncWebServerResponse *response = request->beginResponse(LittleFS, "/www/app.js.gz", "application/javascript");
-            response->addHeader("Content-Encoding", "gzip");
-            response->addHeader("Cache-Control", "no-store");
-            request->send(response);
-            return;
-        }
-        request->send(404, "text/plain", "app.js(.gz) not found");
-    });
-    server.serveStatic("/script.js", LittleFS, "/www/script.js").setCacheControl("no-store");
-    
-    // Static mapping for images (explicit, cache-safe during dev)
-    // 🔎 Routing: Serve static image assets from /www/img.
-    //    Cache disabled (no-store) for development; can be set to long-term cache in production.
-    server.serveStatic("/img", LittleFS, "/www/img")
-          .setCacheControl("no-store");
+    setupEvents();
     
     server.on("/api/config", HTTP_POST, [](AsyncWebServerRequest *request) {}, NULL,
         [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
             String body = String((char*)data).substring(0, len);
             int keyStart = body.indexOf("\"apiKey\":\"") + 10;
             int keyEnd = body.indexOf("\"", keyStart);
-            apiKey = body.substring(keyStart, keyEnd);
-            
-            prefs.begin("config", false);
-            prefs.putString("apiKey", apiKey);
-            prefs.end();
-            
-            request->send(200, "application/json", "{\"status\":\"ok\"}");
+            ApiResult r = opConfig(body.substring(keyStart, keyEnd));
+            request->send(r.code, "application/json", r.body);
         }
     );
     
@@ -608,39 +2651,47 @@ void setupWebServer() {
     });
     
     server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String json = "{";
-        {
-            int wInt = (int)(currentWeight + (currentWeight >= 0 ? 0.5f : -0.5f));
-            json += "\"weight\":" + String(wInt) + ",";
-            // Insert rawWeight and smoothWeight after weight
-            json += "\"rawWeight\":" + String(currentWeight, 2) + ",";
-            json += "\"smoothWeight\":" + String((int)(currentWeight + (currentWeight >= 0 ? 0.5f : -0.5f))) + ",";
+        StatusBuf* b = statusAcquire();
+        if (!b) {
+            request->send(503, "application/json", "{\"error\":\"starting\"}");
+            return;
         }
-        // Hold mode info
-        json += "\"hold\":" + String(holdMode ? "true" : "false") + ",";
-        json += "\"holdWeight\":" + String((int)(holdWeight + (holdWeight>=0?0.5f:-0.5f))) + ",";
-        json += "\"uid\":\"" + lastUID + "\",";
-        json += "\"uid_hex\":\"" + lastUIDHex + "\",";
-        json += "\"wifi\":\"" + WiFi.SSID() + "\",";
-        json += "\"ip\":\"" + WiFi.localIP().toString() + "\",";
-        json += "\"mdns\":\"" + gMdnsName + ".local\",";
-        json += "\"cloud\":\"" + String(cloudOK ? "ok" : "down") + "\",";
-        json += "\"apiKey\":\"" + apiKey + "\",";
-        json += "\"apiValid\":" + String(apiValid ? "true" : "false") + ",";
-        json += "\"displayName\":\"" + apiDisplayName + "\",";
-        json += "\"calibrationFactor\":" + String(calibrationFactor, 4) + ",";
-        json += "\"uptime_ms\":" + String(millis()) + ","; // milliseconds since boot
-        json += "\"uptime_s\":" + String(millis() / 1000) + ",";
-        // sendToCloud status: "3","2","1","send","success","error" or ""
-        String stc;
-        if (sendPhase == "countdown" && sendCountdown >= 0)       stc = String(sendCountdown);
-        else if (sendPhase == "send")                              stc = "send";
-        else if (sendPhase == "success")                           stc = "success";
-        else if (sendPhase == "error")                             stc = "error";
-        else                                                        stc = "";
-        json += "\"sendToCloud\":\"" + stc + "\"";
-        json += "}";
-        request->send(200, "application/json", json);
+        // ?since=<version>: only the fields changed after it; a version from another boot gets everything
+        uint32_t since = 0;
+        bool delta = false;
+        if (request->hasParam("since")) {
+            since = strtoul(request->getParam("since")->value().c_str(), NULL, 10);
+            delta = since >= gStatusBootVersion && since <= b->version;
+        }
+        if (etagMatches(request, b->etag) || (delta && since == b->version)) {
+            AsyncWebServerResponse* res = request->beginResponse(304);
+            statusHeaders(res, b);
+            statusRelease(b);
+            request->send(res);
+            return;
+        }
+        AsyncWebHeader* accept = request->getHeader("Accept");
+        if (accept && accept->value().indexOf("application/msgpack") >= 0) {
+            uint8_t mp[StatusSchema::mpMax];
+            size_t n = StatusSchema::toMsgPack(b->state, mp);
+            AsyncResponseStream* res = request->beginResponseStream("application/msgpack", n);
+            res->write(mp, n);
+            statusHeaders(res, b);
+            statusRelease(b);
+            request->send(res);
+            return;
+        }
+        if (delta) {
+            char json[StatusSchema::jsonMax + 1];
+            size_t n = StatusSchema::toJsonSince(b->state, b->fieldVersion, since, json);
+            AsyncResponseStream* res = request->beginResponseStream("application/json", n);
+            res->write((const uint8_t*)json, n);
+            statusHeaders(res, b);
+            statusRelease(b);
+            request->send(res);
+            return;
+        }
+        request->send(new StatusResponse(b));
     });
 
     // REST: set/validate API key
@@ -665,6 +2716,7 @@ void setupWebServer() {
                 apiKey = newKey;
                 apiValid = true;
                 if (dn.length()) apiDisplayName = dn;
+                statusTouch();
                 prefs.begin("config", false);
                 prefs.putString("apiKey", apiKey);
                 prefs.putString("apiName", apiDisplayName);
@@ -752,6 +2804,74 @@ void setupWebServer() {
         request->send(200, "text/plain", ok ? "ok" : "fail");
     });
 
+    // REST: last complete multi-tag scan
+    server.on("/api/inventory", HTTP_GET, [](AsyncWebServerRequest *request){
+        String json = "{\"tags\":[";
+        char uidDec[UID_DEC_LEN];
+        for (int i = 0; i < gInvCount; ++i) {
+            if (i) json += ",";
+            json += "\""; json += gInvTags[i].toDec(uidDec); json += "\"";
+        }
+        json += "],\"ageMs\":" + String(millis() - gInvLastMs) + "}";
+        request->send(200, "application/json", json);
+    });
+
+    // Diagnostic: RC522 transport cost (detect latency = request → UID, SPI bytes per request)
+    server.on("/api/rfid-stats", HTTP_GET, [](AsyncWebServerRequest *request){
+        const RfidStats& st = gRfidStats;
+        char buf[288];
+        snprintf(buf, sizeof(buf),
+            "{\"fastTransport\":%s,\"spiHz\":%lu,\"polls\":%lu,\"spiBytes\":%lu,\"bytesPerPoll\":%lu,"
+            "\"detects\":%lu,\"lastDetectUs\":%lu,\"avgDetectUs\":%lu,\"maxDetectUs\":%lu,"
+            "\"asleep\":%s,\"sleeps\":%lu}",
+            RC522_FAST_TRANSPORT ? "true" : "false", (unsigned long)MFRC522_SPICLOCK,
+            (unsigned long)st.polls, (unsigned long)st.spiBytes,
+            (unsigned long)(st.polls ? st.spiBytes / st.polls : 0),
+            (unsigned long)st.detects, (unsigned long)st.lastDetectUs,
+            (unsigned long)(st.detects ? st.sumDetectUs / st.detects : 0), (unsigned long)st.maxDetectUs,
+            gRfidAsleep ? "true" : "false", (unsigned long)gRfidSleeps);
+        request->send(200, "application/json", buf);
+    });
+
+    // Diagnostic: OLED flush cost
+    server.on("/api/display-stats", HTTP_GET, [](AsyncWebServerRequest *request){
+        const OledStats& st = gOledStats;   // written by the display task; a torn read is harmless here
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+            "{\"i2cHz\":%lu,\"chunk\":%u,\"framesSent\":%lu,\"framesSkipped\":%lu,\"pagesSent\":%lu,"
+            "\"i2cBytes\":%lu,\"i2cBytesPerSec\":%lu,\"lastFrameUs\":%lu,\"maxFrameUs\":%lu,"
+            "\"sparkSteps\":%lu,\"sparkRecentres\":%lu}",
+            (unsigned long)OLED_I2C_HZ, (unsigned)gOledChunk,
+            (unsigned long)st.framesSent, (unsigned long)st.framesSkipped, (unsigned long)st.pagesSent,
+            (unsigned long)st.i2cBytes, (unsigned long)st.bytesPerSec,
+            (unsigned long)st.lastFrameUs, (unsigned long)st.maxFrameUs,
+            (unsigned long)st.sparkSteps, (unsigned long)st.sparkRecentres);
+        request->send(200, "application/json", buf);
+    });
+
+    // Long-poll: next settled weight, optionally for one UID (?uid=<dec>&timeout=<ms>&after=<seq>)
+    server.on("/api/wait-stable", HTTP_GET, handleWaitStable);
+
+    // Diagnostic: admission control (heap floors, client caps, rejections)
+    server.on("/api/governor-stats", HTTP_GET, [](AsyncWebServerRequest *request){
+        const GovStats& st = gGov;
+        char buf[384];
+        snprintf(buf, sizeof(buf),
+            "{\"freeHeap\":%lu,\"maxBlock\":%lu,\"minFreeHeap\":%lu,\"minMaxBlock\":%lu,"
+            "\"http\":%u,\"httpPeak\":%u,\"httpMax\":%u,\"ws\":%u,\"wsMax\":%u,\"sse\":%u,\"sseMax\":%u,"
+            "\"admitted\":%lu,\"rejectedLow\":%lu,\"rejectedNormal\":%lu,\"rejectedHigh\":%lu,"
+            "\"rejectedBusy\":%lu,\"rejectedWs\":%lu,\"rejectedSse\":%lu,\"wsShed\":%lu}",
+            (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMaxAllocHeap(),
+            (unsigned long)st.minFreeHeap, (unsigned long)st.minMaxBlock,
+            (unsigned)gHttpInFlight, (unsigned)st.httpPeak, (unsigned)GOV_MAX_HTTP,
+            (unsigned)ws.count(), (unsigned)GOV_MAX_WS, (unsigned)events.count(), (unsigned)GOV_MAX_SSE,
+            (unsigned long)st.admitted, (unsigned long)st.rejectedHeap[PRIO_LOW],
+            (unsigned long)st.rejectedHeap[PRIO_NORMAL], (unsigned long)st.rejectedHeap[PRIO_HIGH],
+            (unsigned long)st.rejectedBusy, (unsigned long)st.rejectedWs, (unsigned long)st.rejectedSse,
+            (unsigned long)st.wsShed);
+        request->send(200, "application/json", buf);
+    });
+
     // Simple ping endpoint to diagnose transport issues
     server.on("/api/ping", HTTP_GET, [](AsyncWebServerRequest *request){
         request->send(200, "text/plain", "pong");
@@ -775,42 +2895,22 @@ void setupWebServer() {
             if (w <= 0 && num.indexOf('0') != 0 && num.indexOf('.') != 0) { request->send(400, "application/json", "{\"error\":\"invalid weight\"}"); return; }
 
             // optional uid override
-            String uidOverride = lastUID;
+            char uidOverride[UID_DEC_LEN];
+            lastUID.toDec(uidOverride);
             int up = body.indexOf("\"uid\"");
             if (up >= 0) {
                 int c2 = body.indexOf(':', up);
                 int uq1 = (c2 >= 0) ? body.indexOf('"', c2+1) : -1;
                 int uq2 = (uq1 >= 0) ? body.indexOf('"', uq1+1) : -1;
-                if (uq1 >= 0 && uq2 > uq1) uidOverride = body.substring(uq1+1, uq2);
+                if (uq1 >= 0 && uq2 > uq1) {
+                    if (uq2 - uq1 - 1 >= (int)sizeof(uidOverride)) { request->send(400, "application/json", "{\"error\":\"bad uid\"}"); return; }
+                    memcpy(uidOverride, body.c_str() + uq1 + 1, uq2 - uq1 - 1);
+                    uidOverride[uq2 - uq1 - 1] = '\0';
+                }
             }
 
-            if (apiKey.length() == 0) { request->send(400, "application/json", "{\"error\":\"missing apiKey\"}"); return; }
-            if (uidOverride.length() == 0) { request->send(400, "application/json", "{\"error\":\"missing uid (present a tag)\"}"); return; }
-
-            HTTPClient http;
-            const char* url = "https://us-central1-tigertag-connect.cloudfunctions.net/setSpoolWeightByRfid";
-            if (!http.begin(url)) { request->send(500, "application/json", "{\"error\":\"http begin failed\"}"); return; }
-            http.addHeader("Content-Type", "application/json");
-            http.addHeader("x-api-key", apiKey);
-            String payload = String("{\"uid\":\"") + uidOverride + "\",\"weight\":" + String(wi) + "}";
-            int code = http.POST(payload);
-            String resp = http.getString();
-            http.end();
-
-            if (code >= 200 && code < 300) {
-                currentWeight = (float)wi;
-                displayMessage("Synced \xE2\x9C\x93", String(wi) + " g", "to cloud");
-                delay(700);
-                lastUID = "";
-                lastPushedWeight = NAN;
-                stableSinceMs = 0;
-                stableCandidate = NAN;
-                displayWeight(currentWeight, lastUID);
-                request->send(200, "application/json", "{\"status\":\"ok\"}");
-            } else {
-                String err = String("{\"error\":\"upstream ") + code + "\",\"body\":" + '"' + resp + '"' + "}";
-                request->send(502, "application/json", err);
-            }
+            ApiResult r = opPushWeight(wi, uidOverride);
+            request->send(r.code, "application/json", r.body);
         }
     );
 
@@ -829,48 +2929,32 @@ void setupWebServer() {
             int wi = (int)(w + (w >= 0 ? 0.5f : -0.5f));
             if (w <= 0 && num.indexOf('0') != 0 && num.indexOf('.') != 0) { request->send(400, "application/json", "{\"error\":\"invalid weight\"}"); return; }
 
-            if (apiKey.length() == 0) { request->send(400, "application/json", "{\"error\":\"missing apiKey\"}"); return; }
-            if (lastUID.length() == 0) { request->send(400, "application/json", "{\"error\":\"missing uid (present a tag)\"}"); return; }
-
-            HTTPClient http;
-            const char* url = "https://us-central1-tigertag-connect.cloudfunctions.net/setSpoolWeightByRfid";
-            if (!http.begin(url)) { request->send(500, "application/json", "{\"error\":\"http begin failed\"}"); return; }
-            http.addHeader("Content-Type", "application/json");
-            http.addHeader("x-api-key", apiKey);
-            String payload = String("{\"uid\":\"") + lastUID + "\",\"weight\":" + String(wi) + "}";
-            int code = http.POST(payload);
-            String resp = http.getString();
-            http.end();
-
-            if (code >= 200 && code < 300) {
-                currentWeight = (float)wi;
-                displayMessage("Synced \xE2\x9C\x93", String(wi) + " g", "to cloud");
-                delay(700);
-                lastUID = "";
-                lastPushedWeight = NAN;
-                stableSinceMs = 0;
-                stableCandidate = NAN;
-                char buf[64];
-                snprintf(buf, sizeof(buf), "{\"weight\":%d,\"uid\":\"%s\"}", wi, lastUID.c_str());
-                ws.textAll(buf);
-                displayWeight(currentWeight, lastUID);
-                request->send(200, "application/json", "{\"status\":\"ok\"}");
-            } else {
-                String err = String("{\"error\":\"upstream ") + code + "\",\"body\":" + '"' + resp + '"' + "}";
-                request->send(502, "application/json", err);
-            }
+            ApiResult r = opPushWeight(wi, nullptr);
+            request->send(r.code, "application/json", r.body);
         }
     );
 
     server.on("/api/tare", HTTP_POST, [](AsyncWebServerRequest *request){
-        scale.tare();
-        currentWeight = 0.0f;
-        char buf[64];
-        snprintf(buf, sizeof(buf), "{\"weight\":%.2f,\"uid\":\"%s\"}", currentWeight, lastUID.c_str());
-        ws.textAll(buf);
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
+        ApiResult r = opTare();
+        request->send(r.code, "application/json", r.body);
     });
 
+    // REST: enable/disable weight write-back onto the tag — expects { enabled: true|false }
+    server.on("/api/tag-writeback", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
+        [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
+            StaticJsonDocument<64> doc;
+            if (deserializeJson(doc, (const char*)data, len) || !doc["enabled"].is<bool>()) {
+                request->send(400, "application/json", "{\"error\":\"missing enabled\"}");
+                return;
+            }
+            tagWriteBack = doc["enabled"].as<bool>();
+            prefs.begin("config", false);
+            prefs.putBool("tagWb", tagWriteBack);
+            prefs.end();
+            request->send(200, "application/json", String("{\"status\":\"ok\",\"enabled\":") + (tagWriteBack ? "true" : "false") + "}");
+        }
+    );
+
     server.on("/api/calibration", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL,
         [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
             String body = String((const char*)data).substring(0, len);
@@ -882,18 +2966,22 @@ void setupWebServer() {
             String num = body.substring(colon+1); num.trim();
             while (num.length() && (num[num.length()-1] < '0' || num[num.length()-1] > '9') && num[num.length()-1] != '.' && num[num.length()-1] != '-') num.remove(num.length()-1);
             while (num.length() && ((num[0] < '0' || num[0] > '9') && num[0] != '-' && num[0] != '.')) num.remove(0,1);
-            float f = num.toFloat();
-            if (f == 0.0f) { request->send(400, "application/json", "{\"error\":\"invalid factor\"}"); return; }
-
-            calibrationFactor = f;
-            scale.set_scale(calibrationFactor);
-            prefs.begin("config", false);
-            prefs.putFloat("calFactor", calibrationFactor);
-            prefs.end();
-            request->send(200, "application/json", "{\"status\":\"ok\"}");
+            ApiResult r = opCalibration(num.toFloat());
+            request->send(r.code, "application/json", r.body);
         }
     );
+
+    // Several of the above in one request (see handleBatch)
+    server.on("/api/batch", HTTP_POST, [](AsyncWebServerRequest *request){}, NULL, handleBatch);
     
+    // ============================================
+    // Fichiers statiques (page, CSS/JS, images) : un seul handler, enregistré après l'API
+    // ============================================
+    // 🔎 Routing: Every other GET is looked up in the web pack, then in LittleFS /www.
+    //    The smallest variant (br / gz / raw) allowed by Accept-Encoding is sent, with Vary,
+    //    an ETag (304 on match), and immutable caching for content-hashed names only.
+    server.addHandler(&gWebAssetHandler);
+
     // Page 404
     server.onNotFound([](AsyncWebServerRequest *request) {
         Serial.printf("[404] %s %s\n", request->method() == HTTP_GET ? "GET" : request->method() == HTTP_POST ? "POST" : request->method() == HTTP_DELETE ? "DELETE" : request->method() == HTTP_PUT ? "PUT" : "OTHER", request->url().c_str());
@@ -907,7 +2995,7 @@ void setupWebServer() {
 // Helper: push weight to TigerTag Cloud Function
 bool pushWeightToCloud(float w) {
     if (!wifiConnected || !WiFi.isConnected()) return false;
-    if (apiKey.length() == 0 || lastUID.length() == 0) return false;
+    if (apiKey.length() == 0 || lastUID.empty()) return false;
 
     HTTPClient http;
     const char* url = "https://us-central1-tigertag-connect.cloudfunctions.net/setSpoolWeightByRfid";
@@ -915,8 +3003,10 @@ bool pushWeightToCloud(float w) {
     http.addHeader("Content-Type", "application/json");
     http.addHeader("x-api-key", apiKey);
     int wInt = (int)(w + (w >= 0 ? 0.5f : -0.5f));
-    String payload = String("{\"uid\":\"") + lastUID + "\",\"weight\":" + String(wInt) + "}";
-    int code = http.POST(payload);
+    char uidDec[UID_DEC_LEN];
+    char payload[64];
+    int plen = snprintf(payload, sizeof(payload), "{\"uid\":\"%s\",\"weight\":%d}", lastUID.toDec(uidDec), wInt);
+    int code = http.POST((uint8_t*)payload, plen);
     String resp = http.getString();
     http.end();
     if (code >= 200 && code < 300) {
@@ -936,7 +3026,7 @@ void handleAutoPush(float w) {
     }
 
     // Preconditions to consider any auto-send
-    if (w < MIN_WEIGHT_TO_SEND_G || apiKey.length() == 0 || lastUID.length() == 0 || !WiFi.isConnected()) {
+    if (w < MIN_WEIGHT_TO_SEND_G || apiKey.length() == 0 || lastUID.empty() || !WiFi.isConnected()) {
         sendPhase = "";            // idle
         sendCountdown = -1;
         stableSinceMs = 0;
@@ -982,30 +3072,27 @@ void handleAutoPush(float w) {
     // Ready to send
     sendPhase = "send";
     sendCountdown = 0;
+    sseSync(w);     // the push below blocks the loop: announce "send" before it
 
-    displayMessage("Sending...", String("UID ") + lastUID, String(w, 1) + " g");
+    char uidDec[UID_DEC_LEN];
+    showToast(TOAST_INFO, 5000, "Sending...", String("UID ") + lastUID.toDec(uidDec), String(w, 1) + " g");
     bool ok = pushWeightToCloud(w);
     if (ok) {
         int wInt = (int)(w + (w >= 0 ? 0.5f : -0.5f));
         lastPushedWeight = w;
         lastPushMs = now;
-        displayMessage("Synced \xE2\x9C\x93", String(wInt) + " g", "to cloud");
-        delay(700);
-        lastUID = "";
+        showToast(TOAST_OK, 1500, "Synced \xE2\x9C\x93", String(wInt) + " g", "to cloud");
+        lastUID.clear();
         lastPushedWeight = NAN;
         stableSinceMs = 0;
         stableCandidate = NAN;
-        char buf[64];
-        snprintf(buf, sizeof(buf), "{\"weight\":%d,\"uid\":\"%s\"}", wInt, lastUID.c_str());
-        ws.textAll(buf);
+        gWsKick = true;
         displayWeight((float)wInt, lastUID);
         sendPhase = "success";
         sendPhaseLastChangeMs = millis();
         sendCountdown = -1;
     } else {
-        displayMessage("Sync failed", "Check Wi‑Fi/API", String(w, 1) + " g");
-        delay(700);
-        displayWeight(w, lastUID);
+        showToast(TOAST_ERROR, 2000, "Sync failed", "Check Wi‑Fi/API", String(w, 1) + " g");
         sendPhase = "error";
         sendPhaseLastChangeMs = millis();
         sendCountdown = -1;
@@ -1038,6 +3125,7 @@ void onWiFiEvent(WiFiEvent_t event) {
             wifiConnected = true;
             Serial.println("[WiFi] GOT_IP: " + WiFi.localIP().toString());
             startMDNS();
+            statusTouch();
             break;
         case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
 #ifdef SYSTEM_EVENT_STA_DISCONNECTED
@@ -1046,6 +3134,7 @@ void onWiFiEvent(WiFiEvent_t event) {
             wifiConnected = false;
             Serial.println("[WiFi] DISCONNECTED");
             MDNS.end();
+            statusTouch();
             break;
         default:
             break;
@@ -1061,8 +3150,7 @@ void setupScale() {
     scale.set_scale(calibrationFactor);
     scale.tare();
     
-    displayMessage("Scale OK", "Tare done");
-    delay(1000);
+    showToast(TOAST_INFO, 1000, "Scale OK", "Tare done");
 }
 
 float readWeight() {
@@ -1072,6 +3160,7 @@ float readWeight() {
 
     // 1) Fast raw read (low latency)
     float raw = scale.get_units(1);
+    gRawWeight = raw;
 
     // 2) Update small median window
     gMedianBuf[gMedianIdx] = raw;
@@ -1100,47 +3189,521 @@ float readWeight() {
 // GESTION RFID
 // ============================================================================
 
-static String u64ToDec(uint64_t v) {
-    if (v == 0) return String("0");
-    char buf[21];
-    buf[20] = '\0';
-    int i = 20;
-    while (v > 0 && i > 0) {
-        uint64_t q = v / 10ULL;
-        uint8_t r = (uint8_t)(v - q * 10ULL);
-        buf[--i] = '0' + r;
-        v = q;
+// --- RC522 fast transport ---
+// The library issues REQA with its 25 ms timer and polls ComIrqReg back-to-back with one SPI
+// transaction per register: an empty field costs ~25 ms of blocking and a few kB of SPI per poll.
+// This path keeps the library for select/read/write and only replaces the request (REQA/WUPA),
+// which is what runs on every loop() pass.
+
+const uint16_t RC522_REQA_TIMEOUT_TICKS    = 40;    // × 25 µs = 1 ms (ATQA arrives ~90 µs after REQA)
+const uint16_t RC522_DEFAULT_TIMEOUT_TICKS = 1000;  // library default set by PCD_Init(): 25 ms
+const uint32_t RC522_REQA_POLL_US          = 50;    // ComIrqReg poll period while waiting for ATQA
+
+static const SPISettings kRc522Spi(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0);
+
+static inline void rcBegin() { SPI.beginTransaction(kRc522Spi); digitalWrite(RC522_SS, LOW); }
+static inline void rcEnd()   { digitalWrite(RC522_SS, HIGH); SPI.endTransaction(); }
+
+// Register addresses are already shifted in MFRC522::PCD_Register; bit 7 set = read
+static void rcWrite(byte reg, byte val) {
+    rcBegin();
+    SPI.transfer(reg);
+    SPI.transfer(val);
+    rcEnd();
+    gRfidStats.spiBytes += 2;
+}
+
+// Burst write: after the address byte every byte goes to the same register (FIFO)
+static void rcWriteBurst(byte reg, const byte* data, byte n) {
+    rcBegin();
+    SPI.transfer(reg);
+    for (byte i = 0; i < n; ++i) SPI.transfer(data[i]);
+    rcEnd();
+    gRfidStats.spiBytes += n + 1;
+}
+
+// Batched read: each address byte clocks out the previous register, n registers in n+1 bytes
+static void rcReadMany(const byte* regs, byte n, byte* out) {
+    rcBegin();
+    SPI.transfer(0x80 | regs[0]);
+    for (byte i = 1; i < n; ++i) out[i - 1] = SPI.transfer(0x80 | regs[i]);
+    out[n - 1] = SPI.transfer(0);
+    rcEnd();
+    gRfidStats.spiBytes += n + 1;
+}
+
+static byte rcRead(byte reg) {
+    byte v;
+    rcReadMany(&reg, 1, &v);
+    return v;
+}
+
+static void rcSetTimeout(uint16_t ticks) {
+    rcWrite(MFRC522::TReloadRegH, ticks >> 8);
+    rcWrite(MFRC522::TReloadRegL, ticks & 0xFF);
+}
+
+// 🔎 RC522 Transport: REQA (0x26) or WUPA (0x52) as a 7-bit short frame with a 1 ms timeout.
+//    Register writes are direct (no read-modify-write) and the status tail is one batched read.
+static MFRC522::StatusCode rc522Request(byte cmd) {
+    rcSetTimeout(RC522_REQA_TIMEOUT_TICKS);
+    rcWrite(MFRC522::CollReg, 0x00);                 // ValuesAfterColl=0
+    rcWrite(MFRC522::CommandReg, MFRC522::PCD_Idle);
+    rcWrite(MFRC522::ComIrqReg, 0x7F);
+    rcWrite(MFRC522::FIFOLevelReg, 0x80);            // flush FIFO
+    rcWriteBurst(MFRC522::FIFODataReg, &cmd, 1);
+    rcWrite(MFRC522::BitFramingReg, 0x07);           // TxLastBits = 7
+    rcWrite(MFRC522::CommandReg, MFRC522::PCD_Transceive);
+    rcWrite(MFRC522::BitFramingReg, 0x87);           // StartSend
+
+    MFRC522::StatusCode result = MFRC522::STATUS_TIMEOUT;
+    const uint32_t t0 = micros();
+    while (micros() - t0 < 3000) {                   // hard stop if the timer IRQ never shows up
+        byte irq = rcRead(MFRC522::ComIrqReg);
+        if (irq & 0x30) { result = MFRC522::STATUS_OK; break; } // RxIRq | IdleIRq
+        if (irq & 0x01) break;                       // TimerIRq: nobody answered
+        delayMicroseconds(RC522_REQA_POLL_US);
+    }
+
+    if (result == MFRC522::STATUS_OK) {
+        static const byte tail[] = { MFRC522::ErrorReg, MFRC522::FIFOLevelReg, MFRC522::ControlReg,
+                                     MFRC522::FIFODataReg, MFRC522::FIFODataReg };
+        byte v[sizeof(tail)];
+        rcReadMany(tail, sizeof(tail), v);
+        const byte err = v[0], level = v[1], lastBits = v[2] & 0x07;
+        if (err & 0x13)                     result = MFRC522::STATUS_ERROR;     // BufferOvfl ParityErr ProtocolErr
+        else if (err & 0x08)                result = MFRC522::STATUS_COLLISION; // several tags, anticollision follows
+        else if (level != 2 || lastBits)    result = MFRC522::STATUS_ERROR;     // ATQA must be 16 bits
+    }
+
+    rcSetTimeout(RC522_DEFAULT_TIMEOUT_TICKS);       // select/read/write go through the library
+    return result;
+}
+
+#if !RC522_FAST_TRANSPORT
+// Library PICC_REQA_or_WUPA() traffic, 2 bytes per register access: CollReg clear and StartSend set
+// are read-modify-writes (2 accesses each), plus 6 writes (the 1-byte FIFO burst is also 2 bytes).
+// Then one ComIrqReg read per poll; once the wait ends, ErrorReg, and when something answered,
+// FIFOLevel + a 2-byte FIFO burst (3 bytes) + ControlReg.
+const uint8_t RC522_LIB_SETUP_OPS = 10;
+uint32_t gRc522PollUs = 0;          // one ComIrqReg read + yield(), measured in setupRFID()
+
+// The poll count is not visible from outside the library: the call time over the measured poll time
+static uint32_t rc522LibBytes(MFRC522::StatusCode st, uint32_t us) {
+    uint32_t ops = gRc522PollUs ? us / gRc522PollUs : 0;
+    uint32_t polls = ops > RC522_LIB_SETUP_OPS ? ops - RC522_LIB_SETUP_OPS : 1;
+    uint32_t tail = st == MFRC522::STATUS_TIMEOUT ? 0 : st == MFRC522::STATUS_ERROR ? 2 : 2 + 2 + 3 + 2;
+    return RC522_LIB_SETUP_OPS * 2 + polls * 2 + tail;
+}
+#endif
+
+// Single entry point for REQA/WUPA so both transports can be compared on the same build
+MFRC522::StatusCode rfidRequest(byte cmd) {
+    gRfidStats.polls++;
+#if RC522_FAST_TRANSPORT
+    return rc522Request(cmd);
+#else
+    byte atqa[2];
+    byte atqaSize = sizeof(atqa);
+    const uint32_t t0 = micros();
+    MFRC522::StatusCode st = rfid.PICC_REQA_or_WUPA(cmd, atqa, &atqaSize);
+    gRfidStats.spiBytes += rc522LibBytes(st, micros() - t0);
+    return st;
+#endif
+}
+
+// --- TigerTag payload reader + LRU cache ---
+
+#define NTAG_CMD_FAST_READ 0x3A
+
+struct TagCacheEntry {
+    TagUid uid;
+    uint32_t uidHash;
+    TigerTagData data;
+    uint32_t lastUse;   // 0 = empty slot
+};
+static TagCacheEntry gTagCache[TAG_CACHE_SIZE];
+static uint32_t gTagCacheTick = 0;
+
+static TagCacheEntry* tagCacheFind(const TagUid& uid) {
+    const uint32_t h = uid.hash();
+    for (int i = 0; i < TAG_CACHE_SIZE; ++i) {
+        if (gTagCache[i].lastUse && gTagCache[i].uidHash == h && gTagCache[i].uid == uid) return &gTagCache[i];
     }
-    return String(&buf[i]);
+    return nullptr;
+}
+
+// Empty slot first, otherwise the least recently used one
+static TagCacheEntry* tagCacheVictim() {
+    TagCacheEntry* victim = &gTagCache[0];
+    for (int i = 0; i < TAG_CACHE_SIZE; ++i) {
+        if (!gTagCache[i].lastUse) return &gTagCache[i];
+        if (gTagCache[i].lastUse < victim->lastUse) victim = &gTagCache[i];
+    }
+    return victim;
+}
+
+static inline uint16_t be16(const byte* p) { return ((uint16_t)p[0] << 8) | p[1]; }
+static inline uint32_t be24(const byte* p) { return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2]; }
+static inline uint32_t be32(const byte* p) { return ((uint32_t)be16(p) << 16) | be16(p + 2); }
+
+// Decode in place from the raw page dump (page 4 at offset 0), no allocation
+static bool parseTigerTag(const byte* raw, TigerTagData& out) {
+    out.tagId      = be32(raw + 0);
+    out.productId  = be32(raw + 4);
+    out.materialId = be16(raw + 8);
+    out.aspect1    = raw[10];
+    out.aspect2    = raw[11];
+    out.typeId     = raw[12];
+    out.diameterId = raw[13];
+    out.brandId    = be16(raw + 14);
+    memcpy(out.rgba, raw + 16, 4);
+    out.measure    = be24(raw + 20);
+    out.unitId     = raw[23];
+    out.tempMin    = be16(raw + 24);
+    out.tempMax    = be16(raw + 26);
+    out.dryTemp    = raw[28];
+    out.dryTime    = raw[29];
+    out.timestamp  = be32(raw + 36);
+    out.wbValid    = raw[40] == TAG_WB_MARKER;
+    out.wbWeight   = out.wbValid ? be24(raw + 41) : 0;
+    out.wbTime     = out.wbValid ? be32(raw + 44) : 0;
+    // Blank / non-TigerTag chips read back as all 0x00 or all 0xFF
+    return out.tagId != 0 && out.tagId != 0xFFFFFFFFUL;
+}
+
+// FAST_READ (NTAG21x): whole page range in a single transceive. Response + CRC must fit the 64-byte FIFO.
+static bool ntagFastRead(byte firstPage, byte lastPage, byte* out, byte outLen) {
+    byte cmd[5] = { NTAG_CMD_FAST_READ, firstPage, lastPage, 0, 0 };
+    if (rfid.PCD_CalculateCRC(cmd, 3, &cmd[3]) != MFRC522::STATUS_OK) return false;
+    byte resp[64];
+    byte respLen = sizeof(resp);
+    if (rfid.PCD_TransceiveData(cmd, sizeof(cmd), resp, &respLen, nullptr, 0, true) != MFRC522::STATUS_OK) return false;
+    if (respLen < outLen + 2) return false;
+    memcpy(out, resp, outLen);
+    return true;
+}
+
+// Plain READ returns 4 pages (16 bytes) per transceive; works on every Ultralight/NTAG
+static bool ntagBurstRead(byte firstPage, byte* out, byte outLen) {
+    for (byte off = 0; off < outLen; off += 16) {
+        byte buf[18];
+        byte bufLen = sizeof(buf);
+        if (rfid.MIFARE_Read(firstPage + off / 4, buf, &bufLen) != MFRC522::STATUS_OK) return false;
+        memcpy(out + off, buf, min<byte>(16, outLen - off));
+    }
+    return true;
+}
+
+// A NAK drops the tag back to IDLE: wake it and select it again before retrying
+static bool reselectTag(const TagUid& uid) {
+    MFRC522::StatusCode st = rfidRequest(MFRC522::PICC_CMD_WUPA);
+    if (st != MFRC522::STATUS_OK && st != MFRC522::STATUS_COLLISION) return false; // COLLISION: several tags woke up
+    MFRC522::Uid probe;
+    uid.toMfrc(probe);
+    return rfid.PICC_Select(&probe, probe.size * 8) == MFRC522::STATUS_OK;
+}
+
+// 🔎 TigerTag: Returns the decoded payload of the selected tag. A tag already seen this session
+//    is served from the LRU cache without touching the RF field.
+bool readTigerTagCached(const TagUid& uid, TigerTagData& out) {
+    TagCacheEntry* hit = tagCacheFind(uid);
+    if (hit) {
+        hit->lastUse = ++gTagCacheTick;
+        out = hit->data;
+        return true;
+    }
+
+    const byte len = (TIGERTAG_LAST_PAGE - TIGERTAG_FIRST_PAGE + 1) * 4;
+    byte raw[(TIGERTAG_LAST_PAGE - TIGERTAG_FIRST_PAGE + 1) * 4];
+    bool ok = ntagFastRead(TIGERTAG_FIRST_PAGE, TIGERTAG_LAST_PAGE, raw, len);
+    if (!ok && reselectTag(uid)) ok = ntagBurstRead(TIGERTAG_FIRST_PAGE, raw, len);
+    if (!ok) {
+        Serial.println("[TAG] payload read failed");
+        return false;
+    }
+    if (!parseTigerTag(raw, out)) return false; // not cached: may be written later in the session
+
+    TagCacheEntry* slot = tagCacheVictim();
+    slot->uid = uid;
+    slot->uidHash = uid.hash();
+    slot->data = out;
+    slot->lastUse = ++gTagCacheTick;
+    return true;
 }
 
 void setupRFID() {
     SPI.begin();
     rfid.PCD_Init();
-    displayMessage("RFID OK", "RC522 ready");
-    delay(1000);
+#if !RC522_FAST_TRANSPORT
+    const uint32_t t0 = micros();
+    for (int i = 0; i < 32; ++i) { rfid.PCD_ReadRegister(MFRC522::ComIrqReg); yield(); }
+    gRc522PollUs = max<uint32_t>(1, (micros() - t0) / 32);
+#endif
+    showToast(TOAST_INFO, 1000, "RFID OK", "RC522 ready");
 }
 
-String readRFID() {
-    if (!rfid.PICC_IsNewCardPresent() || !rfid.PICC_ReadCardSerial()) {
-        return "";
+// Returns true and fills `out` when a new (non-halted) tag answered REQA.
+// While no tag is tracked the request is WUPA: the inventory halts every tag it selects, and a tag
+// whose first read failed at the edge of the field would otherwise stay invisible until it left.
+bool readRFID(TagUid& out) {
+    const uint32_t t0 = micros();
+    MFRC522::StatusCode st = rfidRequest(gTagUid.empty() ? MFRC522::PICC_CMD_WUPA : MFRC522::PICC_CMD_REQA);
+    if ((st != MFRC522::STATUS_OK && st != MFRC522::STATUS_COLLISION) || !rfid.PICC_ReadCardSerial()) {
+        return false;
     }
+    const uint32_t detectUs = micros() - t0;
+    gRfidStats.detects++;
+    gRfidStats.lastDetectUs = detectUs;
+    gRfidStats.sumDetectUs += detectUs;
+    if (detectUs > gRfidStats.maxDetectUs) gRfidStats.maxDetectUs = detectUs;
+
+    out = TagUid::from(rfid.uid);
+
+    // Tag is still selected here: fetch its TigerTag payload (cache hit = no extra transceive)
+    gTagDataValid = readTigerTagCached(out, gTagData);
+
+    rfid.PICC_HaltA();
+    return true;
+}
+
+// 🔎 RFID Presence: A read tag is halted, so REQA no longer sees it and nothing tells us it left.
+//    WUPA wakes halted tags, then a SELECT with the full known UID skips the anticollision loop:
+//    only our tag can answer. Cheap enough to run every TAG_PRESENCE_INTERVAL_MS.
+static bool tagStillPresent() {
+    if (!reselectTag(gTagUid)) return false;
+    rfid.PICC_HaltA();
+    return true;
+}
+
+void onTagArrived(const TagUid& uid) {
+    // Remember the tag so the presence tracker can re-select this exact one
+    gTagUid = uid;
+    gTagPresent = true;
+    gTagMisses = 0;
+    gTagLastCheckMs = millis();
+    char uidDec[UID_DEC_LEN], uidHex[UID_HEX_LEN];
+    Serial.printf("[TAG] arrived DEC=%s HEX=%s\n", uid.toDec(uidDec), uid.toHex(uidHex));
+    TagEvent ev;
+    ev.type = "tagArrived";
+    ev.uid = uid;
+    ev.tag.has = gTagDataValid;
+    if (ev.tag.has) tagStateFrom(gTagData, ev.tag.v);
+    char buf[TagArrivedSchema::jsonMax + 1];
+    uint8_t mp[TagArrivedSchema::mpMax];
+    size_t n = TagArrivedSchema::toJson(ev, buf);
+    size_t m = gWsMsgpackPeers ? TagArrivedSchema::toMsgPack(ev, mp) : 0;
+    wsBroadcast(buf, n, mp, m);
+}
+
+// Removal invalidates anything that could still push the old UID with the next spool's weight
+void onTagRemoved() {
+    char uidDec[UID_DEC_LEN];
+    Serial.printf("[TAG] removed DEC=%s\n", gTagUid.toDec(uidDec));
+    TagEvent ev;
+    ev.type = "tagRemoved";
+    ev.uid = gTagUid;
+    char buf[TagRemovedSchema::jsonMax + 1];
+    uint8_t mp[TagRemovedSchema::mpMax];
+    size_t n = TagRemovedSchema::toJson(ev, buf);
+    size_t m = gWsMsgpackPeers ? TagRemovedSchema::toMsgPack(ev, mp) : 0;
+    gTagUid.clear();
+    gTagDataValid = false;
+    lastUID.clear();
+    lastPushedWeight = NAN;
+    stableSinceMs = 0;
+    stableCandidate = NAN;
+    sendPhase = "";
+    sendCountdown = -1;
+    wsBroadcast(buf, n, mp, m);
+}
+
+// Debounced: a single lost frame (RF noise, spool wobble) must not drop the UID
+void trackTagPresence() {
+    if (!gTagPresent) return;
+    const uint32_t now = millis();
+    if (now - gTagLastCheckMs < TAG_PRESENCE_INTERVAL_MS) return;
+    gTagLastCheckMs = now;
 
-    String hexStr; hexStr.reserve(rfid.uid.size * 2);
-    uint64_t decVal = 0ULL;
-    for (byte i = 0; i < rfid.uid.size; i++) {
-        byte b = rfid.uid.uidByte[i];
-        if (b < 0x10) hexStr += '0';
-        hexStr += String(b, HEX);
-        decVal = (decVal << 8) | b;
+    if (tagStillPresent()) {
+        gTagMisses = 0;
+        return;
     }
-    hexStr.toUpperCase();
+    if (++gTagMisses < TAG_REMOVE_MISSES) return;
+
+    gTagPresent = false;
+    gTagMisses = 0;
+    onTagRemoved();
+}
+
+// Writes one page and reads it back (READ returns 4 pages, the first is ours)
+static bool ntagWriteVerified(byte page, const byte* data) {
+    byte w[4];
+    memcpy(w, data, 4);
+    if (rfid.MIFARE_Ultralight_Write(page, w, sizeof(w)) != MFRC522::STATUS_OK) return false;
+    byte r[18];
+    byte rLen = sizeof(r);
+    if (rfid.MIFARE_Read(page, r, &rLen) != MFRC522::STATUS_OK) return false;
+    return memcmp(r, data, 4) == 0;
+}
 
-    lastUIDHex = hexStr;
-    String decStr = u64ToDec(decVal);
+static uint32_t epochNow() {
+    time_t t = time(nullptr);
+    return (t > 1700000000) ? (uint32_t)t : 0; // SNTP not synced yet → 0
+}
 
+// 🔎 Tag write-back: Stores the last stable weight + timestamp on the spool itself (pages 14..15),
+//    so offline stations and printers can read it without the cloud. Skipped when unchanged.
+void handleTagWriteBack(float w) {
+    if (!holdMode) { gWbDoneForHold = false; return; }
+    if (!tagWriteBack || gWbDoneForHold || !gTagPresent || !gTagDataValid) return;
+    if (w < MIN_WEIGHT_TO_SEND_G) return;
+    gWbDoneForHold = true;
+
+    uint32_t grams = (uint32_t)(w + 0.5f);
+    if (grams > 0xFFFFFF) grams = 0xFFFFFF;
+    if (gTagData.wbValid && gTagData.wbWeight == grams) return;
+
+    uint32_t ts = epochNow();
+    byte pw[4] = { TAG_WB_MARKER, (byte)(grams >> 16), (byte)(grams >> 8), (byte)grams };
+    byte pt[4] = { (byte)(ts >> 24), (byte)(ts >> 16), (byte)(ts >> 8), (byte)ts };
+
+    // Time page first: a torn write leaves the old weight with a newer time, never a new weight with a stale time
+    bool ok = reselectTag(gTagUid)
+           && ntagWriteVerified(TAG_WB_PAGE_TIME, pt)
+           && ntagWriteVerified(TAG_WB_PAGE_WEIGHT, pw);
     rfid.PICC_HaltA();
-    return decStr;
+    if (!ok) {
+        Serial.printf("[TAG] write-back failed (%lu g)\n", (unsigned long)grams);
+        return;
+    }
+
+    gTagData.wbValid = true;
+    gTagData.wbWeight = grams;
+    gTagData.wbTime = ts;
+    statusTouch();
+    TagCacheEntry* e = tagCacheFind(gTagUid);
+    if (e) e->data = gTagData;
+    Serial.printf("[TAG] write-back %lu g @ %lu\n", (unsigned long)grams, (unsigned long)ts);
+}
+
+// --- Reader power policy ---
+
+static void rfidSleep() {
+    rfid.PCD_AntennaOff();
+    rfid.PCD_SoftPowerDown();
+    gRfidAsleep = true;
+    gRfidSleepBaseline = gRawWeight;
+    gRfidSleeps++;
+    Serial.println("[RFID] idle: antenna off, soft power-down");
+}
+
+static void rfidWake() {
+    rfid.PCD_SoftPowerUp();      // registers are retained, only the oscillator restarts
+    rfid.PCD_AntennaOn();
+    gRfidAsleep = false;
+    gRfidEmptySinceMs = 0;
+    Serial.println("[RFID] load change: reader awake");
+}
+
+// 🔎 RFID Power: Nothing on the scale for RFID_SLEEP_AFTER_MS → no spool, so no tag to read.
+//    The unfiltered HX711 sample wakes the reader on the first sample after a load change,
+//    before the median/EMA filters settle, so tag detection starts as the spool lands.
+//    Returns true when the reader is powered and may be polled this pass.
+bool rfidPowerPolicy(float weight) {
+    const uint32_t now = millis();
+    if (gRfidAsleep) {
+        if (fabs(gRawWeight - gRfidSleepBaseline) < RFID_WAKE_DELTA_G) return false;
+        rfidWake();
+        return true;
+    }
+    if (gTagPresent || fabs(weight) >= RFID_SLEEP_ZERO_G || fabs(gRawWeight) >= RFID_SLEEP_ZERO_G) {
+        gRfidEmptySinceMs = 0;
+        return true;
+    }
+    if (gRfidEmptySinceMs == 0) gRfidEmptySinceMs = now ? now : 1;
+    if (now - gRfidEmptySinceMs < RFID_SLEEP_AFTER_MS) return true;
+    rfidSleep();
+    return false;
+}
+
+// --- Batch inventory ---
+
+static TagUid gInvScan[INVENTORY_MAX_TAGS];       // cycle in progress
+static int gInvScanCount = 0;
+static bool gInvScanning = false;
+static bool gInvWake = false;     // first request of a cycle is WUPA, so halted tags take part too
+static uint8_t gInvFails = 0;
+
+static bool uidInSet(const TagUid& u, const TagUid* set, int n) {
+    for (int i = 0; i < n; ++i) if (set[i] == u) return true;
+    return false;
+}
+
+// Publishes the new set with what changed since the previous scan (nothing sent when identical)
+static void finishInventory() {
+    gInvScanning = false;
+    gInvLastMs = millis();
+
+    StaticJsonDocument<1536> out;
+    JsonArray added = out.createNestedArray("added");
+    JsonArray removed = out.createNestedArray("removed");
+    char uidDec[UID_DEC_LEN];   // char* (not const char*): ArduinoJson copies it into the document
+    for (int i = 0; i < gInvScanCount; ++i)
+        if (!uidInSet(gInvScan[i], gInvTags, gInvCount)) added.add(gInvScan[i].toDec(uidDec));
+    for (int i = 0; i < gInvCount; ++i)
+        if (!uidInSet(gInvTags[i], gInvScan, gInvScanCount)) removed.add(gInvTags[i].toDec(uidDec));
+
+    memcpy(gInvTags, gInvScan, sizeof(TagUid) * gInvScanCount);
+    gInvCount = gInvScanCount;
+    if (added.size() == 0 && removed.size() == 0) return;
+
+    out["type"] = "inventory";
+    JsonArray tags = out.createNestedArray("tags");
+    for (int i = 0; i < gInvCount; ++i) tags.add(gInvTags[i].toDec(uidDec));
+    static char json[INVENTORY_FRAME_LEN];      // loop task only, like wsBroadcastStatus()'s frames
+    static uint8_t mp[INVENTORY_FRAME_LEN];
+    size_t n = serializeJson(out, json, sizeof(json));
+    size_t m = gWsMsgpackPeers ? serializeMsgPack(out, mp, sizeof(mp)) : 0;
+    wsBroadcast(json, n, mp, m);
+    Serial.printf("[INV] %d tag(s), +%u -%u\n", gInvCount, (unsigned)added.size(), (unsigned)removed.size());
+}
+
+// 🔎 RFID Inventory: Request → anticollision/select → HLTA, repeated until nobody answers.
+//    Halted tags ignore REQA, so each round singles out the next tag. Bounded by
+//    INVENTORY_BUDGET_MS per call so a full stack never starves the HX711 path.
+void inventoryStep() {
+    const uint32_t start = millis();
+    if (!gInvScanning) {
+        if (start - gInvLastMs < INVENTORY_INTERVAL_MS) return;
+        gInvScanning = true;
+        gInvWake = true;
+        gInvScanCount = 0;
+        gInvFails = 0;
+    }
+
+    while (millis() - start < INVENTORY_BUDGET_MS) {
+        MFRC522::StatusCode st = rfidRequest(gInvWake ? MFRC522::PICC_CMD_WUPA : MFRC522::PICC_CMD_REQA);
+        gInvWake = false;
+        if (st != MFRC522::STATUS_OK && st != MFRC522::STATUS_COLLISION) { // field is empty of non-halted tags
+            finishInventory();
+            return;
+        }
+
+        MFRC522::Uid u;
+        memset(&u, 0, sizeof(u));
+        if (rfid.PICC_Select(&u, 0) != MFRC522::STATUS_OK) {
+            if (++gInvFails >= INVENTORY_MAX_FAILS) { finishInventory(); return; }
+            continue;
+        }
+        gInvFails = 0;
+        rfid.PICC_HaltA();
+        const TagUid t = TagUid::from(u);
+        if (!uidInSet(t, gInvScan, gInvScanCount)) {
+            if (gInvScanCount == INVENTORY_MAX_TAGS) { finishInventory(); return; }
+            gInvScan[gInvScanCount++] = t;
+        }
+    }
 }
 
 // ============================================================================
@@ -1176,20 +3739,15 @@ bool checkServerHealth() {
 void setup() {
     Serial.begin(115200);
     pinMode(LED_PIN, OUTPUT);
-    Wire.begin(21, 22);
-    
-    if (!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDR)) {
-        Serial.println(F("Erreur OLED"));
-        while (1);
-    }
+    setupDisplay();
     
     displayMessage("TigerTagScale", "Starting...", "v1.1.0");
-    delay(2000);
     
     prefs.begin("config", true);
     apiKey = prefs.getString("apiKey", "");
     calibrationFactor = prefs.getFloat("calFactor", calibrationFactor);
     apiDisplayName = prefs.getString("apiName", "");
+    tagWriteBack = prefs.getBool("tagWb", false);
     prefs.end();
     
     WiFi.onEvent(onWiFiEvent);
@@ -1211,11 +3769,15 @@ void setup() {
     }
     
     setupFileSystem();  // ← AJOUTÉ : Monte LittleFS
+    setupWebPack();
+    statusRefresh(currentWeight);   // first snapshot before the server accepts requests
+    gWsSentVersion = gStatusVersion;
+    gLongPollMutex = xSemaphoreCreateMutex();
     setupWebServer();
     setupScale();
     setupRFID();
     
-    displayMessage(
+    showToast(TOAST_INFO, 3000,
         "READY!",
         "IP: " + WiFi.localIP().toString(),
         gMdnsName + ".local",
@@ -1232,13 +3794,24 @@ void loop() {
         lastBlink = millis();
     }
     
-    String uid = readRFID();
-    if (uid.length() > 0 && uid != lastUID) {
-        lastUID = uid;
-        Serial.println("UID detected (DEC): " + lastUID + "  (HEX): " + lastUIDHex);
-    }
-    
+    // Weight first: the reader power policy needs this pass's sample
     float weight = readWeight();
+    sparkFeed(weight);
+
+    if (rfidPowerPolicy(weight)) {
+        TagUid uid;
+        if (readRFID(uid)) {
+            if (uid != lastUID) {
+                lastUID = uid;
+                gWsKick = true;
+                char uidDec[UID_DEC_LEN], uidHex[UID_HEX_LEN];
+                Serial.printf("UID detected (DEC): %s  (HEX): %s\n", uid.toDec(uidDec), uid.toHex(uidHex));
+            }
+            if (!gTagPresent || uid != gTagUid) onTagArrived(uid);
+        }
+        trackTagPresence();
+        inventoryStep();
+    }
 
     // --- Hold mode logic ---
     float displayedWeight = weight;
@@ -1248,6 +3821,8 @@ void loop() {
             if (millis() - holdStartMs > HOLD_TIME_MS) {
                 holdMode = true;
                 holdWeight = weight;
+                gStableSeq++;
+                gWsKick = true;
             }
         } else {
             holdStartMs = 0;
@@ -1258,36 +3833,47 @@ void loop() {
             holdMode = false;
             holdStartMs = 0;
             holdWeight = weight;
+            gWsKick = true;
         }
     }
     displayedWeight = holdMode ? holdWeight : weight;
 
-    if (millis() - lastUpdate > WS_UPDATE_INTERVAL_MS) {
+    // Every WS_UPDATE_INTERVAL_MS while the reading moves, at once for discrete events (tag, hold,
+    // tare, push, settings: gWsKick), otherwise only the heartbeat.
+    if (gWsKick || millis() - lastUpdate > WS_UPDATE_INTERVAL_MS) {
+        static uint32_t lastWsSendMs = 0;
+        gWsKick = false;
         displayWeight(displayedWeight, lastUID);
         
-        int wInt = (int)(displayedWeight + (displayedWeight >= 0 ? 0.5f : -0.5f));
-        String json = "{\"weight\":" + String(wInt) + 
-                      ",\"uid\":\"" + lastUID + "\"}";
-        ws.textAll(json);
-        ws.cleanupClients();
+        // Broadcast only new versions, as the fields changed since the last broadcast (each client got
+        // the full object on connect); textAll() queues one shared buffer for every client.
+        // Under memory pressure skip the tick rather than push the heap under the floor: the version
+        // stays unsent, so the next tick retries from the same base even if nothing else changes.
+        statusRefresh(displayedWeight);
+        StatusBuf* b = statusAcquire();
+        if (b && b->version != gWsSentVersion) {
+            if (ws.count() == 0) gWsSentVersion = b->version;
+            else if (!heapAllows(PRIO_NORMAL)) gGov.wsShed++;
+            else {
+                wsBroadcastStatus(b, gWsSentVersion);
+                gWsSentVersion = b->version;
+                lastWsSendMs = millis();
+            }
+        }
+        if (b) statusRelease(b);
+        if (ws.count() > 0 && millis() - lastWsSendMs > WS_HEARTBEAT_MS) {
+            wsBroadcastBeat(gWsSentVersion);
+            lastWsSendMs = millis();
+        }
+        ws.cleanupClients(GOV_MAX_WS);
+        sseSync(displayedWeight);
         
         lastUpdate = millis();
     }
 
-    // Periodically rebroadcast API status so late joiners / stale UIs sync automatically
-    if (millis() - lastApiBroadcastMs > 5000) { // every 5s
-        if (ws.count() > 0) {
-            StaticJsonDocument<192> out;
-            out["type"] = "apiStatus";
-            out["valid"] = apiValid;
-            if (apiValid && apiDisplayName.length()) out["displayName"] = apiDisplayName;
-            String outStr; serializeJson(out, outStr);
-            ws.textAll(outStr);
-        }
-        lastApiBroadcastMs = millis();
-    }
-
+    longPollService();
     handleAutoPush(weight);
+    handleTagWriteBack(displayedWeight);
     
     delay(10);
 }
\ No newline at end of file
@@ -221,8 +221,12 @@ let currentWeight = null;
 let currentUid = null;
 let calFactor = null;
 let apiKey = '';
+let apiValid = false;
+let apiName = '';
 let cloudStatus = 'unknown';
 let apiStatus = 'none';
+let uptimeBase = NaN;   // device uptime (s) at uptimeAt; the display ticks locally in between
+let uptimeAt = 0;
 
 // ========== UTILITIES ==========
 function setTextIfChanged(el, txt) {
@@ -798,16 +802,18 @@ function applyStatusSnapshot(s) {
     
     // API Key
     const apiInput = document.getElementById('newApiKey');
-    if (apiInput && typeof s.apiKey === 'string' && apiKey !== s.apiKey) {
+    if (typeof s.apiKey === 'string' && apiKey !== s.apiKey) {
         apiKey = s.apiKey;
-        if (apiInput.value !== apiKey) apiInput.value = apiKey;
+        if (apiInput && apiInput.value !== apiKey) apiInput.value = apiKey;
     }
     
-    // API Status
-    if (typeof s.apiKey === 'string') {
-        const hasKey = s.apiKey.trim().length > 0;
-        const state = hasKey ? (s.apiValid ? 'valid' : 'invalid') : 'none';
-        setApiStatus(state, s.displayName || '');
+    // API Status (a change message only carries the fields that changed)
+    if (typeof s.apiKey === 'string' || typeof s.apiValid !== 'undefined' || typeof s.displayName === 'string') {
+        if (typeof s.apiValid !== 'undefined') apiValid = !!s.apiValid;
+        if (typeof s.displayName === 'string') apiName = s.displayName;
+        const hasKey = apiKey.trim().length > 0;
+        const state = hasKey ? (apiValid ? 'valid' : 'invalid') : 'none';
+        setApiStatus(state, apiName);
     }
     
     // Calibration factor
@@ -820,9 +826,9 @@ function applyStatusSnapshot(s) {
     
     // Uptime
     if (typeof s.uptime_s !== 'undefined' || typeof s.uptime_ms !== 'undefined') {
-        let secs = (typeof s.uptime_s !== 'undefined') ? Number(s.uptime_s) : Number(s.uptime_ms) / 1000;
-        const upEl = document.getElementById('uptime');
-        setTextIfChanged(upEl, formatHMS(secs));
+        uptimeBase = (typeof s.uptime_ms !== 'undefined') ? Number(s.uptime_ms) / 1000 : Number(s.uptime_s);
+        uptimeAt = Date.now();
+        renderUptime();
     }
     
     // Send to cloud status
@@ -844,13 +850,100 @@ function applyStatusSnapshot(s) {
     }
 }
 
+function renderUptime() {
+    const upEl = document.getElementById('uptime');
+    setTextIfChanged(upEl, formatHMS(uptimeBase + (Date.now() - uptimeAt) / 1000));
+}
+
+// ========== LIVE UPDATES ==========
+// /ws sends the full status object on connect, then only the fields that changed.
+// Every frame carries "seq"; change frames also carry "base", the seq they apply on top of,
+// and an idle device sends a bare {"seq"} heartbeat every 15 s. A base (or heartbeat)
+// newer than ours means a frame was dropped: ask for the full object again.
+// While the socket is down, /api/status is polled instead, with ?since=<ETag version>
+// so that each poll returns only the changes too (or a bodiless 304).
+let socket = null;
+let socketRetryMs = 1000;
+let socketSeenAt = 0;
+let socketSeq = null;
+let pollTimer = null;
+let statusVersion = null;
+
+function onSocketFrame(m) {
+    if (!m || m.type || typeof m.seq !== 'number') return;   // typed messages repeat status fields
+    const isDelta = typeof m.base === 'number';
+    if (!isDelta && Object.keys(m).length > 1) {               // full object
+        socketSeq = m.seq;
+        applyStatusSnapshot(m);
+        return;
+    }
+    if (socketSeq === null) {                                  // before the full object
+        if (isDelta) applyStatusSnapshot(m);
+        return;
+    }
+    if (m.seq <= socketSeq) return;
+    if (!isDelta || m.base > socketSeq) {
+        socketSeq = null;                                      // until the full object arrives
+        socket.send(JSON.stringify({ type: 'resync' }));
+        return;
+    }
+    socketSeq = m.seq;
+    applyStatusSnapshot(m);
+}
+
+function connectSocket() {
+    const proto = location.protocol === 'https:' ? 'wss://' : 'ws://';
+    socket = new WebSocket(proto + location.host + '/ws');
+    socketSeq = null;
+    socket.onopen = () => {
+        socketRetryMs = 1000;
+        socketSeenAt = Date.now();
+        stopPolling();
+    };
+    socket.onmessage = (ev) => {
+        socketSeenAt = Date.now();
+        let m;
+        try { m = JSON.parse(ev.data); } catch (_) { return; }
+        onSocketFrame(m);
+    };
+    socket.onclose = () => {
+        socket = null;
+        startPolling();
+        setTimeout(connectSocket, socketRetryMs);
+        socketRetryMs = Math.min(socketRetryMs * 2, 30000);
+    };
+}
+
+// Two missed heartbeats: treat the link as dead and fall back to polling
+function checkSocket() {
+    if (socket && socket.readyState === WebSocket.OPEN && Date.now() - socketSeenAt > 35000) socket.close();
+}
+
 function pollStatus() {
-    fetch('/api/status', { cache: 'no-store' })
-    .then(r => r.ok ? r.json() : Promise.reject(r.status))
+    const url = statusVersion ? '/api/status?since=' + statusVersion : '/api/status';
+    fetch(url, { cache: 'no-store' })
+    .then(r => {
+        if (r.status === 304) return null;
+        if (!r.ok) return Promise.reject(r.status);
+        const v = /"(\d+)"/.exec(r.headers.get('ETag') || '');
+        statusVersion = v ? v[1] : null;
+        return r.json();
+    })
     .then(s => applyStatusSnapshot(s))
     .catch(() => {});
 }
 
+function startPolling() {
+    if (pollTimer) return;
+    pollStatus();
+    pollTimer = setInterval(pollStatus, 1000);
+}
+
+function stopPolling() {
+    clearInterval(pollTimer);
+    pollTimer = null;
+}
+
 // ========== INITIALIZATION ==========
 window.onload = () => {
     // Set language
@@ -859,9 +952,10 @@ window.onload = () => {
     // Initial weight display
     setTextIfChanged(weightEl, '…');
     
-    // Start polling
-    pollStatus();
-    setInterval(pollStatus, 1000);
+    // Live updates: WebSocket, HTTP polling only while it is down
+    connectSocket();
+    setInterval(checkSocket, 5000);
+    setInterval(renderUptime, 1000);
     
     // Register Service Worker for PWA
     if ('serviceWorker' in navigator) {